@@ -11,30 +11,89 @@
 //  - 5 levels: lengths 100m,200m,300m,400m,500m (increasing steepness)
 //  - Terrain black; pr
 
+#ifdef _WIN32
+#define NOMINMAX // SFML/OpenGL.hpp pulls in <windows.h>
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#pragma comment(lib, "opengl32.lib") // glReadPixels/glFinish/glFlush are called directly
+#endif
+#endif
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
 #include <SFML/System.hpp>
+#include <SFML/OpenGL.hpp>
 #include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <iterator>
 #include <vector>
 #include <string>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <filesystem>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <new>
 
 // ---------------------------- Config ---------------------------------
 static const unsigned WINDOW_W = 1280;
 static const unsigned WINDOW_H = 720;
 static const float   PPM = 8.0f;      // pixels per meter (1 m = 8 px)
-static const float   GRAVITY = 40.0f;     // px/s^2 downward
 static const float   DT_FIXED = 1.0f / 120.f;// fixed-step physics
 
 
 // Level lengths (meters)
 static const int LEVEL_METERS[5] = { 300, 500, 700, 900, 1100 };
 
-// Fuel rules
-static const float FUEL_TANK_METERS = 100.0f;    // full tank lasts 50 m
-static const float FUEL_CAN_GAP_M = 80.0f;    // cans appear every 40 m
+// Tunables. These defaults can be overridden live from the tuning file (see the
+// Tuning section); the main thread only swaps them between physics steps, so
+// the hot paths read plain fields of one global.
+struct Tuning {
+    // Vehicle
+    float gravity = 40.0f;              // px/s^2 downward
+    float accel = 300.0f;               // px/s^2 along car direction
+    float torque = 1.8f;                // rad/s^2 (air)
+    float slopeAlignRate = 4.5f;        // rad/s toward the ground slope
+    float groundFriction = 0.999f;      // per step, wheels down
+    float groundFrictionNoFuel = 0.99f;
+    float groundAngularDamping = 0.92f;
+    float airDrag = 0.9998f;            // per step
+    float airAngularDamping = 0.999f;
+
+    // Fuel rules
+    float fuelTankMeters = 100.0f;      // full tank lasts 100 m
+    float fuelCanGapMeters = 80.0f;     // cans appear every 80 m
+
+    // Terrain coefficients; level n adds n * perLevel
+    float groundBase = 0.80f;           // fraction of the window height
+    float roughBase = 15.0f, roughPerLevel = 10.0f;
+    float freq1Base = 1.0f / 140.0f, freq1PerLevel = 0.0008f;
+    float freq2Base = 1.0f / 280.0f, freq2PerLevel = 0.0005f;
+};
+static Tuning g_tuning;
+
+// FNV-1a over every tunable; baked level data records the one it was measured under
+sf::Uint32 tuningHash(const Tuning& t) {
+    static_assert(sizeof(Tuning) % sizeof(float) == 0, "Tuning holds floats only");
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&t);
+    sf::Uint32 h = 2166136261u;
+    for (size_t i = 0; i < sizeof(Tuning); i++) {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
 
 // Coin rules
 static const int   COINS_PER_LEVEL = 20;
@@ -46,37 +105,318 @@ float clampf(float v, float lo, float hi) { return std::max(lo, std::min(v, hi))
 // Procedural terrain function; returns ground Y (px) and slope (dy/dx) for a given x (px)
 struct GroundSample { float y; float slope; };
 
-GroundSample sampleGround(float x_px, int levelIndex) {
+// Coefficients of the terrain sine-sum for one level. Shared by the CPU sampler
+// and the terrain fragment shader so both evaluate exactly the same curve.
+struct TerrainParams { float base, rough, freq1, freq2; };
+
+TerrainParams terrainParams(int levelIndex) {
+    TerrainParams p;
     // Base ground around 3/4 height up the screen from top (white background)
-    float base = WINDOW_H * 0.80f; // lower is larger y
+    p.base = WINDOW_H * g_tuning.groundBase; // lower is larger y
 
     // Increase roughness with level
-    float rough = 15.0f + levelIndex * 10.0f;   // amplitude multiplier (px)
-    float freq1 = 1.0f / 140.0f + levelIndex * 0.0008f; // spatial frequency
-    float freq2 = 1.0f / 280.0f + levelIndex * 0.0005f;
+    p.rough = g_tuning.roughBase + levelIndex * g_tuning.roughPerLevel;   // amplitude multiplier (px)
+    p.freq1 = g_tuning.freq1Base + levelIndex * g_tuning.freq1PerLevel; // spatial frequency
+    p.freq2 = g_tuning.freq2Base + levelIndex * g_tuning.freq2PerLevel;
+    return p;
+}
 
-    float y = base
-        - rough * std::sin(x_px * freq1)
-        - 0.6f * rough * std::sin(x_px * freq2 + 1.7f)
-        - 0.3f * rough * std::sin(x_px * (freq1 * 2.3f) + 0.6f);
+inline float terrainHeight(float x_px, const TerrainParams& p) {
+    return p.base
+        - p.rough * std::sin(x_px * p.freq1)
+        - 0.6f * p.rough * std::sin(x_px * p.freq2 + 1.7f)
+        - 0.3f * p.rough * std::sin(x_px * (p.freq1 * 2.3f) + 0.6f);
+}
+
+// Analytic d2y/dx2 of terrainHeight (px^-1); drives adaptive tessellation
+inline float terrainCurvature(float x_px, const TerrainParams& p) {
+    float f3 = p.freq1 * 2.3f;
+    return p.rough * p.freq1 * p.freq1 * std::sin(x_px * p.freq1)
+        + 0.6f * p.rough * p.freq2 * p.freq2 * std::sin(x_px * p.freq2 + 1.7f)
+        + 0.3f * p.rough * f3 * f3 * std::sin(x_px * f3 + 0.6f);
+}
+
+GroundSample sampleGround(float x_px, int levelIndex) {
+    TerrainParams p = terrainParams(levelIndex);
+    float y = terrainHeight(x_px, p);
 
     // Numerical slope via small delta
     float dx = 1.0f;
-    float y2 = base
-        - rough * std::sin((x_px + dx) * freq1)
-        - 0.6f * rough * std::sin((x_px + dx) * freq2 + 1.7f)
-        - 0.3f * rough * std::sin((x_px + dx) * (freq1 * 2.3f) + 0.6f);
+    float y2 = terrainHeight(x_px + dx, p);
     float slope = (y2 - y) / dx; // dy/dx in px/px
     return { y, slope };
 }
 
+// Generated levels store their ground as heights every HEIGHTFIELD_STEP_PX and
+// read it back through a Catmull-Rom spline: the slope stays continuous for the
+// physics and the curvature is known for adaptive tessellation.
+static const float HEIGHTFIELD_STEP_PX = 8.0f; // 1 m
+
+struct Heightfield {
+    std::pmr::vector<float> y; // ground y (px) at x = i * HEIGHTFIELD_STEP_PX
+
+    explicit Heightfield(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : y(memory) {}
+    bool empty() const { return y.empty(); }
+
+    // Segment polynomial c0 + c1 t + c2 t^2 + c3 t^3 around x, t in 0..1
+    struct Cubic { float c0, c1, c2, c3, t; };
+    Cubic segment(float x_px) const {
+        int last = static_cast<int>(y.size()) - 1;
+        float u = std::max(0.0f, x_px / HEIGHTFIELD_STEP_PX);
+        int i = std::min(static_cast<int>(u), last);
+        auto at = [&](int k) { return y[std::clamp(k, 0, last)]; };
+        float p0 = at(i - 1), p1 = at(i), p2 = at(i + 1), p3 = at(i + 2);
+        return { p1, 0.5f * (p2 - p0), p0 - 2.5f * p1 + 2.0f * p2 - 0.5f * p3,
+                 0.5f * (p3 - p0) + 1.5f * (p1 - p2), std::min(u - i, 1.0f) };
+    }
+    float height(float x_px) const {
+        Cubic c = segment(x_px);
+        return c.c0 + c.t * (c.c1 + c.t * (c.c2 + c.t * c.c3));
+    }
+    float slope(float x_px) const {
+        Cubic c = segment(x_px);
+        return (c.c1 + c.t * (2.0f * c.c2 + c.t * 3.0f * c.c3)) / HEIGHTFIELD_STEP_PX;
+    }
+    float curvature(float x_px) const {
+        Cubic c = segment(x_px);
+        return (2.0f * c.c2 + 6.0f * c.c3 * c.t) / (HEIGHTFIELD_STEP_PX * HEIGHTFIELD_STEP_PX);
+    }
+};
+
+// The curve a terrain cache tessellates: the level's heightfield when it has
+// one, otherwise the designed sine-sum
+struct GroundCurve {
+    const Heightfield* field;
+    TerrainParams p;
+    float height(float x_px) const { return field ? field->height(x_px) : terrainHeight(x_px, p); }
+    float curvature(float x_px) const { return field ? field->curvature(x_px) : terrainCurvature(x_px, p); }
+};
+
 // Convert meters to pixels and vice versa
 inline float m2px(float m) { return m * PPM; }
 inline float px2m(float px) { return px / PPM; }
 
+// ---------------------------- Allocation tracking ---------------------
+// Global operator new is replaced for two jobs:
+//  - Per-frame counts: a thread that installs an AllocCounter counts its own
+//    allocations, attributed to the AllocScope subsystem it is in.
+//    --alloc-check uses this to hold the playing loop to zero allocations per
+//    frame after warm-up.
+//  - Live memory: blocks come straight from malloc, with no header, and a
+//    side table records each block's size and the MemTag that was current on
+//    the allocating thread (MemTagScope). Live heap bytes are therefore
+//    attributed per tag whichever thread frees them. Blocks stay plain malloc
+//    blocks because memory crosses the SFML DLLs in both directions: their
+//    stock operator new allocates storage our inlined destructors free, and
+//    the reverse. A block the table does not know is simply freed. Memory the
+//    C allocator hands out directly (FreeType, stb_image) is not seen here;
+//    the memory report shows it as the gap to process RSS.
+enum AllocSubsystem {
+    AllocOther, AllocPhysics, AllocCamera, AllocBackground, AllocTerrain, AllocPickups,
+    AllocParticles, AllocVehicle, AllocHud, AllocMinimap, AllocStats, AllocPresent, AllocSubsystemCount
+};
+static const char* ALLOC_SUBSYSTEM_NAMES[AllocSubsystemCount] = {
+    "other", "physics", "camera", "background", "terrain", "pickups",
+    "particles", "vehicle", "hud", "minimap", "stats", "present"
+};
+
+struct AllocCounter {
+    size_t count[AllocSubsystemCount] = {};
+    size_t bytes[AllocSubsystemCount] = {};
+    int subsystem = AllocOther;
+
+    size_t total() const {
+        size_t n = 0;
+        for (size_t c : count) n += c;
+        return n;
+    }
+    void clear() {
+        std::fill(std::begin(count), std::end(count), size_t(0));
+        std::fill(std::begin(bytes), std::end(bytes), size_t(0));
+    }
+};
+
+static thread_local AllocCounter* t_allocCounter = nullptr;
+
+// Attributes this thread's allocations to a subsystem until the scope ends
+struct AllocScope {
+    int saved = AllocOther;
+    explicit AllocScope(AllocSubsystem s) {
+        if (t_allocCounter) { saved = t_allocCounter->subsystem; t_allocCounter->subsystem = s; }
+    }
+    ~AllocScope() { if (t_allocCounter) t_allocCounter->subsystem = saved; }
+};
+
+enum MemTag { MemUntagged, MemLevel, MemTerrain, MemRender, MemFont, MemInputLog, MemTelemetry, MemTagCount };
+static const char* MEM_TAG_NAMES[MemTagCount] = { "untagged", "level", "terrain", "render", "font", "input log", "telemetry" };
+static const int MEM_SCREENS = 7; // one peak slot per Screen value
+
+// Constant-initialized, so it is valid for allocations made before main()
+struct MemoryStats {
+    std::atomic<long long> live[MemTagCount] = {};
+    std::atomic<long long> total{ 0 };
+    std::atomic<bool> trackPeaks{ false };
+    std::atomic<int> screen{ 0 };                           // screen state peaks are charged to
+    std::atomic<long long> peakTotal[MEM_SCREENS] = {};
+    std::atomic<long long> peak[MEM_SCREENS][MemTagCount] = {}; // each tag's own high-water mark
+};
+static MemoryStats g_memory;
+static thread_local int t_memTag = MemUntagged;
+
+// Charges this thread's allocations to a memory tag until the scope ends
+struct MemTagScope {
+    int saved;
+    explicit MemTagScope(MemTag tag) : saved(t_memTag) { t_memTag = tag; }
+    ~MemTagScope() { t_memTag = saved; }
+};
+
+inline void raisePeak(std::atomic<long long>& peak, long long value) {
+    long long seen = peak.load(std::memory_order_relaxed);
+    while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+// Block table: pointer -> size and tag, split into shards that each hold a
+// linear-probing table behind a spin lock. Shards are constant-initialized and
+// grow with malloc (never operator new), so they work before main() and
+// inside the allocator. A block that cannot be recorded (table growth failed)
+// is just not counted.
+struct AllocEntry { void* p; size_t size; int tag; };
+
+static const int ALLOC_SHARDS = 64;
+static const size_t ALLOC_SHARD_INITIAL = 1024; // slots, power of two
+
+// Low bits pick the shard, the rest the home slot within it
+inline size_t allocHash(const void* p) {
+    sf::Uint64 h = static_cast<sf::Uint64>(reinterpret_cast<std::uintptr_t>(p) >> 4) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+struct AllocShard {
+    std::atomic<bool> busy{ false };
+    AllocEntry* slots = nullptr; // p == nullptr marks an empty slot
+    size_t mask = 0, count = 0;
+
+    void lock() { while (busy.exchange(true, std::memory_order_acquire)) {} }
+    void unlock() { busy.store(false, std::memory_order_release); }
+
+    size_t home(size_t hash) const { return (hash / ALLOC_SHARDS) & mask; }
+
+    bool grow() {
+        size_t capacity = slots ? (mask + 1) * 2 : ALLOC_SHARD_INITIAL;
+        AllocEntry* next = static_cast<AllocEntry*>(std::calloc(capacity, sizeof(AllocEntry)));
+        if (!next) return false;
+        AllocEntry* old = slots;
+        size_t oldCapacity = slots ? mask + 1 : 0;
+        slots = next;
+        mask = capacity - 1;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (!old[i].p) continue;
+            size_t k = home(allocHash(old[i].p));
+            while (slots[k].p) k = (k + 1) & mask;
+            slots[k] = old[i];
+        }
+        std::free(old);
+        return true;
+    }
+
+    // Records p; a stale entry at the same address (a block freed by another
+    // module's operator delete) is handed back in replaced
+    bool insert(const AllocEntry& e, size_t hash, AllocEntry& replaced) {
+        replaced.p = nullptr;
+        if ((count + 1) * 4 > (slots ? mask + 1 : 0) * 3 && !grow()) return false;
+        size_t k = home(hash);
+        while (slots[k].p && slots[k].p != e.p) k = (k + 1) & mask;
+        if (slots[k].p) replaced = slots[k];
+        else count++;
+        slots[k] = e;
+        return true;
+    }
+
+    // Removes p, closing the probe gap by backward shifting
+    bool erase(const void* p, size_t hash, AllocEntry& out) {
+        if (!slots) return false;
+        size_t i = home(hash);
+        while (slots[i].p != p) {
+            if (!slots[i].p) return false;
+            i = (i + 1) & mask;
+        }
+        out = slots[i];
+        count--;
+        for (size_t j = i;;) {
+            slots[i].p = nullptr;
+            for (;;) {
+                j = (j + 1) & mask;
+                if (!slots[j].p) return true;
+                size_t k = home(allocHash(slots[j].p));
+                bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+                if (!stays) break;
+            }
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+};
+static AllocShard g_allocShards[ALLOC_SHARDS];
+
+inline void chargeLive(int tag, long long bytes) {
+    long long tagLive = g_memory.live[tag].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    long long total = g_memory.total.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (bytes > 0 && g_memory.trackPeaks.load(std::memory_order_relaxed)) {
+        int screen = g_memory.screen.load(std::memory_order_relaxed);
+        raisePeak(g_memory.peakTotal[screen], total);
+        raisePeak(g_memory.peak[screen][tag], tagLive);
+    }
+}
+
+void* operator new(std::size_t n) {
+    if (AllocCounter* c = t_allocCounter) {
+        c->count[c->subsystem]++;
+        c->bytes[c->subsystem] += n;
+    }
+    void* p = std::malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    size_t hash = allocHash(p);
+    AllocShard& shard = g_allocShards[hash % ALLOC_SHARDS];
+    AllocEntry replaced;
+    shard.lock();
+    bool recorded = shard.insert({ p, n, t_memTag }, hash, replaced);
+    shard.unlock();
+    if (replaced.p) chargeLive(replaced.tag, -static_cast<long long>(replaced.size));
+    if (recorded) chargeLive(t_memTag, static_cast<long long>(n));
+    return p;
+}
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    size_t hash = allocHash(p);
+    AllocShard& shard = g_allocShards[hash % ALLOC_SHARDS];
+    AllocEntry e;
+    shard.lock();
+    bool known = shard.erase(p, hash, e);
+    shard.unlock();
+    if (known) chargeLive(e.tag, -static_cast<long long>(e.size));
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+// Resident set size of the process, 0 where unavailable
+size_t processRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.WorkingSetSize;
+    return 0;
+#else
+    long pages = 0, resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    int read = std::fscanf(f, "%ld %ld", &pages, &resident);
+    std::fclose(f);
+    return read == 2 ? static_cast<size_t>(resident) * 4096 : 0;
+#endif
+}
+
 // ---------------------------- Entities --------------------------------
 struct FuelCan { float x_px; bool taken = false; };
-struct Coin { float x_px; float y_px; bool taken = false; };
+struct Coin { float x_px; float y_px; bool taken = false; float hover_px = 50.0f; }; // hover: height above the ground
 
 struct Vehicle {
     // Physical state (car chassis center of mass)
@@ -96,6 +436,8 @@ struct Vehicle {
     // Controls
     bool pressingLeft = false, pressingRight = false;
 
+    int wheelsOnGround = 0; // wheels in ground contact after the last physics step
+
     void reset(float startX, float groundY) {
         x_px = startX; y_px = groundY - wheelR - bodyH * 0.5f - 2.0f;
         vx = vy = 0.0f; angle = 0.02f; angV = 0.0f;
@@ -117,956 +459,4694 @@ struct Vehicle {
     }
 };
 
-// ---------------------------- Game State ------------------------------
-enum class Screen { Menu, Playing, GameOver, LevelComplete, Exit, GameCompleted };
+// ---------------------------- Terrain tessellation --------------------
+// The terrain surface is tessellated per fixed-width chunk: a segment is split
+// until its linear-interpolation error (h^2/8 * |y''|) fits the screen-space
+// error bound. Tolerances are quantized into power-of-two LOD tiers of the
+// camera's world-px-per-screen-px, so each chunk is built at most once per tier.
+static const float TERRAIN_CHUNK_PX = 512.0f;
+static const float TERRAIN_SEED_STEP_PX = 32.0f;   // initial segments at tier 0 (doubles per tier); curvature probe spacing
+static const float TERRAIN_MIN_STEP_PX = 2.0f;
+static const float TERRAIN_MAX_ERROR_SCREEN_PX = 0.5f;
+static const int   TERRAIN_LOD_TIERS = 4;
+
+int terrainLodTier(float worldPerPixel) {
+    int tier = 0;
+    while (tier + 1 < TERRAIN_LOD_TIERS && worldPerPixel > static_cast<float>(1 << tier)) tier++;
+    return tier;
+}
 
-struct Button { sf::RectangleShape rect; sf::Text text; bool hovered = false; };
+// Chunks live in their level's arena (see LevelArena), so they carry an allocator
+struct TerrainChunk {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
 
-struct Level {
-    int index = 0; // 0..4
-    float length_m = 100.0f;
-    float length_px = 800.0f;
-    float finishX_px = 800.0f;
+    bool built = false;
+    std::pmr::vector<sf::Vector2f> points; // surface points, both chunk edges included
+    float maxError_px = 0.0f;              // measured world-space deviation at segment midpoints
 
-    std::vector<FuelCan> cans;
-    std::vector<Coin> coins;
+    explicit TerrainChunk(const allocator_type& alloc = {}) : points(alloc) {}
+    TerrainChunk(const TerrainChunk& o, const allocator_type& alloc)
+        : built(o.built), points(o.points, alloc), maxError_px(o.maxError_px) {}
+    TerrainChunk(TerrainChunk&& o, const allocator_type& alloc)
+        : built(o.built), points(std::move(o.points), alloc), maxError_px(o.maxError_px) {}
 };
 
-struct Game {
-    Screen screen = Screen::Menu;
-    sf::Font font; bool hasFont = false;
-
-    int unlockedLevels = 1; // must beat previous to unlock next
-    int currentLevel = 0;
+struct TerrainCache {
+    using Chunks = std::pmr::vector<TerrainChunk>;
+    static_assert(TERRAIN_LOD_TIERS == 4, "tiers initializer below lists one vector per tier");
 
-    Vehicle car;
-    Level level;
+    int levelIndex = -1;
+    const Heightfield* field = nullptr; // owning level's heightfield (empty for designed levels)
+    Chunks tiers[TERRAIN_LOD_TIERS];
+    std::vector<sf::Vector2f> scratch; // tessellation output; copied into the arena at its exact size
+    int outgrown = 0;                  // rebuilds since reset() that did not fit the chunk's old points
 
-    // Progress
-    float fuel_m = FUEL_TANK_METERS; // remaining meters worth of fuel
-    float lastX_forFuel_px = 0.0f;   // to deduct fuel by horizontal travel
+    explicit TerrainCache(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : tiers{ Chunks(memory), Chunks(memory), Chunks(memory), Chunks(memory) } {}
 
-    int coinsCollected = 0;
-    float levelDistance_m = 0.0f; // current level distance traveled
+    // Drops every chunk without touching the (arena) memory behind them
+    void release() {
+        MemTagScope tag(MemTerrain);
+        for (auto& chunks : tiers) Chunks(chunks.get_allocator()).swap(chunks);
+    }
 
-    // Totals across all finished levels
-    float totalDistance_m = 0.0f;
-    int   totalCoins = 0;
+    void reset(int levelIdx, float extent_px) {
+        MemTagScope tag(MemTerrain);
+        levelIndex = levelIdx;
+        outgrown = 0;
+        size_t count = static_cast<size_t>(std::ceil(extent_px / TERRAIN_CHUNK_PX)) + 1;
+        for (auto& chunks : tiers) {
+            chunks.clear();
+            chunks.reserve(count);
+            chunks.resize(count);
+        }
+    }
 
-    bool headHitGround = false;
-    float fuel_out_timer = -1.0f;
+    // Marks every chunk stale after the terrain curve changed; each one is
+    // re-tessellated the next time it is drawn. Points that fit the chunk's
+    // old storage reuse it; more points (a rougher curve) take a new block
+    // from the arena and strand the old one until the next rewind, counted in
+    // outgrown (and in the arena's spills once past its block).
+    void invalidate() {
+        for (auto& chunks : tiers)
+            for (TerrainChunk& c : chunks) c.built = false;
+    }
 
-    // Menu buttons
-    Button playButton;
-    Button exitButton;
+    // Tessellates every chunk of every tier up front (used off the main thread)
+    void buildAll() {
+        for (int tier = 0; tier < TERRAIN_LOD_TIERS; tier++)
+            for (size_t i = 0; i < tiers[tier].size(); i++)
+                if (!tiers[tier][i].built) build(tiers[tier][i], tier, static_cast<int>(i));
+    }
 
-    void setupFont() {
-        if (font.loadFromFile("C:/Windows/Fonts/arial.ttf")) hasFont = true;
-        else hasFont = false; // HUD will be minimal but playable
+    const TerrainChunk& chunk(int tier, int idx) {
+        TerrainChunk& c = tiers[tier][idx];
+        if (!c.built) build(c, tier, idx);
+        return c;
+    }
 
-        // Initialize buttons if font is loaded
-        if (hasFont) {
-            // Play button
-            playButton.rect.setSize(sf::Vector2f(200.0f, 50.0f));
-            playButton.rect.setFillColor(sf::Color(0, 120, 255)); // Blue
-            playButton.rect.setOutlineColor(sf::Color::Black);
-            playButton.rect.setOutlineThickness(2.0f);
-            playButton.text.setFont(font);
-            playButton.text.setString("Play");
-            playButton.text.setCharacterSize(24);
-            playButton.text.setFillColor(sf::Color::White);
-            // Center button
-            playButton.rect.setPosition((WINDOW_W - 200.0f) / 2, (WINDOW_H - 50.0f * 2 - 20.0f) / 2);
-            sf::FloatRect textBounds = playButton.text.getLocalBounds();
-            playButton.text.setPosition(
-                playButton.rect.getPosition().x + (200.0f - textBounds.width) / 2,
-                playButton.rect.getPosition().y + (50.0f - textBounds.height) / 2 - textBounds.top
-            );
-
-            // Exit button
-            exitButton.rect.setSize(sf::Vector2f(200.0f, 50.0f));
-            exitButton.rect.setFillColor(sf::Color(0, 120, 255)); // Blue
-            exitButton.rect.setOutlineColor(sf::Color::Black);
-            exitButton.rect.setOutlineThickness(2.0f);
-            exitButton.text.setFont(font);
-            exitButton.text.setString("Exit");
-            exitButton.text.setCharacterSize(24);
-            exitButton.text.setFillColor(sf::Color::White);
-            // Center button below play button
-            exitButton.rect.setPosition((WINDOW_W - 200.0f) / 2, playButton.rect.getPosition().y + 50.0f + 20.0f);
-            textBounds = exitButton.text.getLocalBounds();
-            exitButton.text.setPosition(
-                exitButton.rect.getPosition().x + (200.0f - textBounds.width) / 2,
-                exitButton.rect.getPosition().y + (50.0f - textBounds.height) / 2 - textBounds.top
-            );
+    void build(TerrainChunk& c, int tier, int idx) {
+        MemTagScope tag(MemTerrain);
+        GroundCurve g{ field && !field->empty() ? field : nullptr, terrainParams(levelIndex) };
+        float tol = TERRAIN_MAX_ERROR_SCREEN_PX * static_cast<float>(1 << tier);
+        float x0 = idx * TERRAIN_CHUNK_PX;
+
+        std::vector<sf::Vector2f>& out = scratch;
+        out.clear();
+        c.maxError_px = 0.0f;
+        out.push_back(sf::Vector2f(x0, g.height(x0)));
+
+        // Depth-first subdivision; segments are emitted left to right
+        struct Seg { float a, b; };
+        Seg stack[32];
+        const float seed = TERRAIN_SEED_STEP_PX * static_cast<float>(1 << tier);
+        for (float a = x0; a < x0 + TERRAIN_CHUNK_PX; a += seed) {
+            int top = 0;
+            stack[top++] = { a, a + seed };
+            while (top > 0) {
+                Seg s = stack[--top];
+                float h = s.b - s.a;
+                float m = 0.5f * (s.a + s.b);
+                float k = std::max({ std::fabs(g.curvature(s.a)),
+                                     std::fabs(g.curvature(m)),
+                                     std::fabs(g.curvature(s.b)) });
+                float estimate = 1.25f * h * h * 0.125f * k; // 25% margin between probes
+                if (estimate > tol && h * 0.5f >= TERRAIN_MIN_STEP_PX && top + 2 <= 32) {
+                    stack[top++] = { m, s.b };
+                    stack[top++] = { s.a, m };
+                    continue;
+                }
+                float yb = g.height(s.b);
+                float lerpMid = 0.5f * (out.back().y + yb);
+                c.maxError_px = std::max(c.maxError_px, std::fabs(g.height(m) - lerpMid));
+                out.push_back(sf::Vector2f(s.b, yb));
+            }
         }
+        if (c.points.capacity() > 0 && out.size() > c.points.capacity()) outgrown++;
+        c.points.assign(out.begin(), out.end());
+        c.built = true;
     }
+};
 
-    void buildLevel(int idx) {
-        currentLevel = idx;
-        level.index = idx;
-        level.length_m = static_cast<float>(LEVEL_METERS[idx]);
-        level.length_px = m2px(level.length_m);
-        level.finishX_px = level.length_px;
-
-        // Build fuel cans every 40m
-        level.cans.clear();
-        float gap_px = m2px(FUEL_CAN_GAP_M);
-        for (float x = m2px(20.0f); x < level.finishX_px; x += gap_px) {
-            level.cans.push_back({ x,false });
-        }
+// ---------------------------- Camera ----------------------------------
+// The view widens with the car's speed so upcoming hills come into sight, and
+// follows the car vertically with exponential smoothing.
+static const float CAMERA_MAX_ZOOM = 3.5f;          // visible width at top speed, in WINDOW_W units
+static const float CAMERA_ZOOM_SPEED_LO = 150.0f;   // px/s at which zooming out starts
+static const float CAMERA_ZOOM_SPEED_HI = 650.0f;   // px/s at which CAMERA_MAX_ZOOM is reached
+static const float CAMERA_ZOOM_OUT_RATE = 1.5f;     // 1/s
+static const float CAMERA_ZOOM_IN_RATE = 0.6f;      // 1/s, slower so braking doesn't snap the view
+static const float CAMERA_FOLLOW_Y_RATE = 4.0f;     // 1/s
+static const float CAMERA_CAR_SCREEN_Y = 0.75f;     // car's resting height as a fraction of the view
+
+struct Camera {
+    float zoom = 1.0f;
+    float centerY = WINDOW_H * 0.5f;
+
+    float viewW() const { return WINDOW_W * zoom; }
+    float viewH() const { return WINDOW_H * zoom; }
+
+    float targetCenterY(const Vehicle& V) const {
+        return V.y_px - viewH() * (CAMERA_CAR_SCREEN_Y - 0.5f);
+    }
 
-        // Build coins: 20 coins ~10m apart, hovering a bit above ground
-        level.coins.clear();
-        float coinGap_px = level.length_px / (COINS_PER_LEVEL + 1);
-        for (int i = 1; i <= COINS_PER_LEVEL; i++) {
-            float x = i * coinGap_px;
-            auto g = sampleGround(x, currentLevel);
-            float y = g.y - 50.0f; // hover above ground
-            level.coins.push_back({ x, y, false });
-        }
+    void snap(const Vehicle& V) {
+        zoom = 1.0f;
+        centerY = targetCenterY(V);
+    }
 
-        // Reset progress
-        fuel_m = FUEL_TANK_METERS;
-        lastX_forFuel_px = 0.0f;
-        levelDistance_m = 0.0f;
-        coinsCollected = 0;
-        headHitGround = false;
-        fuel_out_timer = -1.0f;
+    void update(const Vehicle& V, float dt) {
+        float speed = std::sqrt(V.vx * V.vx + V.vy * V.vy);
+        float t = clampf((speed - CAMERA_ZOOM_SPEED_LO) / (CAMERA_ZOOM_SPEED_HI - CAMERA_ZOOM_SPEED_LO), 0.0f, 1.0f);
+        float targetZoom = 1.0f + t * (CAMERA_MAX_ZOOM - 1.0f);
+        float rate = targetZoom > zoom ? CAMERA_ZOOM_OUT_RATE : CAMERA_ZOOM_IN_RATE;
+        zoom += (targetZoom - zoom) * (1.0f - std::exp(-rate * dt));
 
-        // Place vehicle at start
-        auto g0 = sampleGround(0.0f, currentLevel);
-        car.reset(10.0f, g0.y);
+        centerY += (targetCenterY(V) - centerY) * (1.0f - std::exp(-CAMERA_FOLLOW_Y_RATE * dt));
+    }
 
-        // Explicitly reset vehicle speed and other relevant variables
-        car.vx = 0.0f;
-        car.vy = 0.0f;
-        car.pressingLeft = false;
-        car.pressingRight = false;
+    // Applies the camera to view, keeping it horizontally inside the level
+    void apply(sf::View& view, const Vehicle& V, float finishX_px) const {
+        float halfW = viewW() * 0.5f;
+        float camX = clampf(V.x_px, halfW, std::max(halfW, finishX_px - halfW));
+        view.setSize(viewW(), viewH());
+        view.setCenter(camX, centerY);
     }
+};
 
-    void resetGame() {
-        unlockedLevels = 1;
-        currentLevel = 0;
-        totalDistance_m = 0.0f;
-        totalCoins = 0;
-        coinsCollected = 0;
-        fuel_m = FUEL_TANK_METERS;
-        lastX_forFuel_px = 0.0f;
-        levelDistance_m = 0.0f;
-        headHitGround = false;
-        fuel_out_timer = -1.0f;
-        car.pressingLeft = false;
-        car.pressingRight = false;
-        buildLevel(0);
+// ---------------------------- Particles -------------------------------
+// Fixed-capacity particle pool stored as structure-of-arrays. Nothing is
+// allocated after construction: spawning past capacity is dropped, dead
+// particles are swap-removed, and the vertex buffer is sized up front.
+static const size_t PARTICLE_CAPACITY = 8192;
+static const float  PARTICLE_BUDGET_MS = 0.08f * 1000.0f / 120.0f; // 8% of a 120 Hz frame
+static const float  PARTICLE_GRAVITY = 60.0f;                     // px/s^2
+static const float  PARTICLE_DRAG = 1.8f;                         // 1/s
+
+// Small deterministic RNG for effects (xorshift32)
+struct FxRandom {
+    sf::Uint32 state = 0x9E3779B9u;
+    float next01() {
+        state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+        return (state >> 8) * (1.0f / 16777216.0f);
     }
+    float range(float lo, float hi) { return lo + (hi - lo) * next01(); }
 };
 
-// ---------------------------- Physics ---------------------------------
-void stepVehicle(Game& G, float dt) {
-    Vehicle& V = G.car;
+struct ParticlePool {
+    size_t capacity = 0;
+    size_t count = 0;
+    std::vector<float> x, y, vx, vy, life, invMaxLife, size;
+    std::vector<sf::Color> color;
+    std::vector<sf::Vertex> verts; // 6 per particle (two triangles)
+    size_t vertCount = 0;
+
+    FxRandom rng;
+    float spawnScale = 1.0f; // < 1 while over budget
+    float cost_ms = 0.0f;    // smoothed update + vertex build cost
+
+    explicit ParticlePool(size_t cap) : capacity(cap) {
+        MemTagScope tag(MemRender);
+        for (auto* v : { &x, &y, &vx, &vy, &life, &invMaxLife, &size }) v->resize(cap);
+        color.resize(cap);
+        verts.resize(cap * 6);
+    }
 
-    // Simple gravity
-    V.vy += GRAVITY * dt;
+    void clear() { count = 0; vertCount = 0; }
 
-    // Tentative position without input acceleration
-    float tempX = V.x_px + V.vx * dt;
-    float tempY = V.y_px + V.vy * dt;
-    float tempAngle = V.angle + V.angV * dt;
+    void spawn(float px, float py, float pvx, float pvy, float lifetime, float sz, sf::Color col) {
+        if (count >= capacity) return;
+        size_t i = count++;
+        x[i] = px; y[i] = py; vx[i] = pvx; vy[i] = pvy;
+        life[i] = lifetime; invMaxLife[i] = 1.0f / lifetime;
+        size[i] = sz; color[i] = col;
+    }
 
-    // Tentative wheel positions
-    sf::Vector2f tempFront = V.localToWorldTemp(tempX, tempY, tempAngle, +V.wheelBase * 0.5f, V.bodyH * 0.5f);
-    sf::Vector2f tempRear = V.localToWorldTemp(tempX, tempY, tempAngle, -V.wheelBase * 0.5f, V.bodyH * 0.5f);
+    // Number of particles to emit for a nominal amount, after the budget throttle;
+    // the fractional part is emitted with matching probability.
+    int budgeted(float amount) {
+        float n = amount * spawnScale;
+        int whole = static_cast<int>(n);
+        return whole + (rng.next01() < n - whole ? 1 : 0);
+    }
 
-    // Check if would be on ground
-    bool onGroundTentative = false;
-    auto checkContact = [&](sf::Vector2f wp) {
-        auto gs = sampleGround(wp.x, G.currentLevel);
-        float groundY = gs.y - V.wheelR;
-        float dy = wp.y - groundY;
-        if (dy > 0.0f) {
-            onGroundTentative = true;
+    void burst(float px, float py, int n, float speed, float lifetime, float sz, sf::Color col) {
+        n = budgeted(static_cast<float>(n));
+        for (int i = 0; i < n; i++) {
+            float a = rng.range(0.0f, 6.2831853f);
+            float sp = rng.range(0.3f, 1.0f) * speed;
+            spawn(px, py, sp * std::cos(a), sp * std::sin(a) - 0.5f * speed, lifetime * rng.range(0.6f, 1.0f), sz, col);
         }
-        };
-    checkContact(tempFront);
-    checkContact(tempRear);
-
-    // Input forces only if fuel > 0
-    if (G.fuel_m > 0.0f) {
-        const float accel = 300.0f;      // px/s^2 along car direction (increased for faster speed)
-        const float torque = 1.8f;       // rad/s^2 (air)
+    }
 
-        if (V.pressingRight) {
-            if (onGroundTentative) {
-                float dirX = std::cos(tempAngle);
-                float dirY = std::sin(tempAngle);
-                V.vx += accel * dt * dirX;
-                V.vy += accel * dt * dirY;
-            }
-            V.angV -= torque * dt; // clockwise (front flip)
-        }
-        if (V.pressingLeft) {
-            if (onGroundTentative) {
-                float dirX = std::cos(tempAngle);
-                float dirY = std::sin(tempAngle);
-                V.vx -= accel * dt * dirX;
-                V.vy -= accel * dt * dirY;
-            }
-            V.angV += torque * dt; // anti-clockwise (back flip)
+    void update(float dt) {
+        const size_t n = count;
+        float* px = x.data(); float* py = y.data();
+        float* pvx = vx.data(); float* pvy = vy.data();
+        float* pl = life.data();
+        const float damp = std::max(0.0f, 1.0f - PARTICLE_DRAG * dt);
+        const float gdt = PARTICLE_GRAVITY * dt;
+
+        // Branch-free loops over contiguous arrays so the compiler can vectorize them
+        for (size_t i = 0; i < n; i++) pvx[i] *= damp;
+        for (size_t i = 0; i < n; i++) pvy[i] = pvy[i] * damp + gdt;
+        for (size_t i = 0; i < n; i++) px[i] += pvx[i] * dt;
+        for (size_t i = 0; i < n; i++) py[i] += pvy[i] * dt;
+        for (size_t i = 0; i < n; i++) pl[i] -= dt;
+
+        // Swap-remove dead particles
+        size_t i = 0;
+        while (i < count) {
+            if (life[i] > 0.0f) { i++; continue; }
+            size_t last = --count;
+            x[i] = x[last]; y[i] = y[last]; vx[i] = vx[last]; vy[i] = vy[last];
+            life[i] = life[last]; invMaxLife[i] = invMaxLife[last];
+            size[i] = size[last]; color[i] = color[last];
         }
     }
 
-    // Integrate position with updated velocities
-    V.x_px += V.vx * dt;
-    V.y_px += V.vy * dt;
-    V.angle += V.angV * dt;
-
-    // Wheel-ground collision & alignment
-    int wheelsOnGround = 0;
-    auto fixWheel = [&](sf::Vector2f wp) {
-        auto gs = sampleGround(wp.x, G.currentLevel);
-        float groundY = gs.y - V.wheelR;
-        float dy = wp.y - groundY;
-        if (dy > 0.0f) { // wheel penetrates ground -> push car up
-            wheelsOnGround++;
-            // Move chassis up by dy projected along body-down direction (approx)
-            V.y_px -= dy;
-            V.vy = std::min(0.0f, V.vy);
-            // Dampen angular velocity and align angle slightly with slope
-            float targetAngle = std::atan(gs.slope);
-            float alignRate = 4.5f * dt;
-            // wrap to nearest
-            float da = targetAngle - V.angle;
-            while (da > 3.14159f) da -= 6.28318f;
-            while (da < -3.14159f) da += 6.28318f;
-            V.angle += clampf(da, -alignRate, alignRate);
+    // Builds the triangle list. Higher LOD tiers draw every 2nd/4th particle,
+    // enlarged to keep roughly the same covered area.
+    void buildVertices(int lodTier) {
+        size_t stride = static_cast<size_t>(1) << std::max(0, lodTier - 1);
+        float grow = std::sqrt(static_cast<float>(stride));
+        sf::Vertex* v = verts.data();
+        for (size_t i = 0; i < count; i += stride) {
+            float h = 0.5f * size[i] * grow;
+            sf::Color c = color[i];
+            c.a = static_cast<sf::Uint8>(c.a * clampf(life[i] * invMaxLife[i], 0.0f, 1.0f));
+            sf::Vector2f a(x[i] - h, y[i] - h), b(x[i] + h, y[i] - h), d(x[i] + h, y[i] + h), e(x[i] - h, y[i] + h);
+            v[0] = sf::Vertex(a, c); v[1] = sf::Vertex(b, c); v[2] = sf::Vertex(d, c);
+            v[3] = sf::Vertex(a, c); v[4] = sf::Vertex(d, c); v[5] = sf::Vertex(e, c);
+            v += 6;
         }
-        };
-
-    fixWheel(V.frontWheelPos());
-    fixWheel(V.rearWheelPos());
+        vertCount = static_cast<size_t>(v - verts.data());
+    }
 
-    if (wheelsOnGround > 0) {
-        float groundFriction = (G.fuel_m > 0.0f ? 0.999f : 0.99f);
-        V.vx *= groundFriction;
-        V.angV *= 0.92f;
+    // Update + vertex build, timed; emission is throttled while over budget
+    void simulate(float dt, int lodTier) {
+        sf::Clock timer;
+        update(dt);
+        buildVertices(lodTier);
+        float ms = timer.getElapsedTime().asMicroseconds() / 1000.0f;
+        cost_ms += (ms - cost_ms) * 0.1f;
+        if (cost_ms > PARTICLE_BUDGET_MS) spawnScale = std::max(0.05f, spawnScale * 0.9f);
+        else spawnScale = std::min(1.0f, spawnScale + 0.01f);
     }
+};
 
-    // Air drag & angular damping
-    V.vx *= 0.9998f;
-    V.angV *= 0.999f;
+// Headless stress benchmark: --bench-particles [count]
+int runParticleBenchmark(size_t n) {
+    ParticlePool pool(n);
+    const int frames = 600;
+    double total_ms = 0.0;
+    sf::Clock timer;
+    for (int f = 0; f < frames; f++) {
+        // Keep the pool saturated with long-lived particles
+        while (pool.count < n)
+            pool.spawn(pool.rng.range(0.0f, 1280.0f), pool.rng.range(0.0f, 720.0f),
+                       pool.rng.range(-50.0f, 50.0f), pool.rng.range(-80.0f, 0.0f),
+                       pool.rng.range(0.5f, 3.0f), 3.0f, sf::Color(120, 120, 120, 200));
+        timer.restart();
+        pool.update(DT_FIXED);
+        pool.buildVertices(0);
+        total_ms += timer.getElapsedTime().asMicroseconds() / 1000.0;
+    }
+    std::cout << "Particles: " << n << "  frames: " << frames << "  avg update+build: "
+              << std::fixed << std::setprecision(3) << total_ms / frames << " ms  ("
+              << std::setprecision(1) << total_ms * 1e6 / (static_cast<double>(frames) * n) << " ns/particle)" << std::endl;
+    return 0;
 }
 
-// Deduct fuel based on horizontal distance traveled; refill on can pickup
-void updateFuelAndPickups(Game& G) {
-    float dx_px = std::fabs(G.car.x_px - G.lastX_forFuel_px);
-    if (dx_px > 0.0f) {
-        float consumed_m = px2m(dx_px);
-        G.fuel_m = std::max(0.0f, G.fuel_m - consumed_m);
-        G.levelDistance_m += consumed_m;
-        G.lastX_forFuel_px = G.car.x_px;
+// ---------------------------- Background ------------------------------
+// Parallax layers (clouds, far hills, near hills, trees) cut from one
+// procedurally painted texture atlas. Sprite placement is generated once per
+// level; each frame the visible sprites of all layers are written into a
+// single textured triangle list, scrolled by a per-layer factor of the camera.
+enum AtlasRegion { AtlasHills, AtlasTree, AtlasCloud, AtlasRegionCount };
+static const unsigned ATLAS_W = 512, ATLAS_H = 256;
+static const sf::IntRect ATLAS_RECTS[AtlasRegionCount] = {
+    sf::IntRect(0, 0, 512, 128),   // hills, tiles horizontally
+    sf::IntRect(0, 128, 96, 128),  // tree
+    sf::IntRect(96, 128, 192, 96), // cloud
+};
+
+struct ParallaxSprite { float x, y, scale; int region; };
+
+struct ParallaxLayer {
+    float scroll = 0.0f;  // fraction of camera motion applied to the layer
+    float period = 0.0f;  // layer repeats every period screen px
+    sf::Color tint;
+    std::vector<ParallaxSprite> sprites;
+};
+
+struct Background {
+    static const int LAYERS = 4;
+    sf::Texture atlas;
+    bool ready = false;
+    ParallaxLayer layers[LAYERS];
+    std::vector<sf::Vertex> verts;
+
+    // Paints the atlas on the CPU and uploads it once
+    void createAtlas() {
+        sf::Image img;
+        paintAtlas(img);
+        uploadAtlas(img);
     }
 
-    sf::Vector2f fw = G.car.frontWheelPos();
-    sf::Vector2f rw = G.car.rearWheelPos();
+    void uploadAtlas(const sf::Image& img) {
+        MemTagScope tag(MemRender);
+        ready = atlas.loadFromImage(img);
+        atlas.setSmooth(true);
+    }
 
-    // Fuel cans
-    for (auto& c : G.level.cans) {
-        if (!c.taken) {
-            auto gs = sampleGround(c.x_px, G.currentLevel);
-            float canY = gs.y - 18.0f;
-            float dx_c = c.x_px - G.car.x_px;
-            float dy_c = canY - G.car.y_px;
-            float dist_c = std::sqrt(dx_c * dx_c + dy_c * dy_c);
-            float dx_f = c.x_px - fw.x;
-            float dy_f = canY - fw.y;
-            float dist_f = std::sqrt(dx_f * dx_f + dy_f * dy_f);
-            float dx_r = c.x_px - rw.x;
-            float dy_r = canY - rw.y;
-            float dist_r = std::sqrt(dx_r * dx_r + dy_r * dy_r);
-            float min_dist = std::min({ dist_c, dist_f, dist_r });
-            if (min_dist < 30.0f) {
-                c.taken = true;
-                G.fuel_m = FUEL_TANK_METERS; // refill to full
+    // CPU only, so it can run on a worker thread
+    static void paintAtlas(sf::Image& img) {
+        MemTagScope tag(MemRender);
+        img.create(ATLAS_W, ATLAS_H, sf::Color(255, 255, 255, 0));
+
+        // Hills: periodic silhouette so neighbouring tiles join seamlessly
+        const sf::IntRect& h = ATLAS_RECTS[AtlasHills];
+        for (int x = 0; x < h.width; x++) {
+            float t = 6.2831853f * x / h.width;
+            float top = h.height * (0.45f - 0.25f * std::sin(t) - 0.12f * std::sin(3.0f * t + 1.3f));
+            for (int y = static_cast<int>(top); y < h.height; y++)
+                img.setPixel(h.left + x, h.top + y, sf::Color::White);
+        }
+
+        // Tree: round canopy over a trunk
+        const sf::IntRect& tr = ATLAS_RECTS[AtlasTree];
+        for (int y = 0; y < tr.height; y++) {
+            for (int x = 0; x < tr.width; x++) {
+                float dx = x - tr.width * 0.5f, dy = y - tr.height * 0.38f;
+                bool canopy = dx * dx + dy * dy < (tr.width * 0.45f) * (tr.width * 0.45f);
+                bool trunk = std::fabs(dx) < 6.0f && y > tr.height * 0.5f;
+                if (canopy || trunk) img.setPixel(tr.left + x, tr.top + y, sf::Color::White);
             }
         }
-    }
 
-    // Coins
-    for (auto& coin : G.level.coins) {
-        if (!coin.taken) {
-            float dx_c = coin.x_px - G.car.x_px;
-            float dy_c = coin.y_px - G.car.y_px;
-            float dist_c = std::sqrt(dx_c * dx_c + dy_c * dy_c);
-            float dx_f = coin.x_px - fw.x;
-            float dy_f = coin.y_px - fw.y;
-            float dist_f = std::sqrt(dx_f * dx_f + dy_f * dy_f);
-            float dx_r = coin.x_px - rw.x;
-            float dy_r = coin.y_px - rw.y;
-            float dist_r = std::sqrt(dx_r * dx_r + dy_r * dy_r);
-            float min_dist = std::min({ dist_c, dist_f, dist_r });
-            if (min_dist < 28.0f) {
-                coin.taken = true;
-                G.coinsCollected++;
+        // Cloud: overlapping soft discs
+        const sf::IntRect& cl = ATLAS_RECTS[AtlasCloud];
+        const float blobs[4][3] = { {0.30f, 0.60f, 0.26f}, {0.52f, 0.45f, 0.32f}, {0.72f, 0.62f, 0.24f}, {0.45f, 0.70f, 0.25f} };
+        for (int y = 0; y < cl.height; y++) {
+            for (int x = 0; x < cl.width; x++) {
+                float a = 0.0f;
+                for (const auto& b : blobs) {
+                    float dx = (x - b[0] * cl.width) / cl.height, dy = (y - b[1] * cl.height) / cl.height;
+                    a = std::max(a, clampf((b[2] - std::sqrt(dx * dx + dy * dy)) * 20.0f, 0.0f, 1.0f));
+                }
+                if (a > 0.0f) img.setPixel(cl.left + x, cl.top + y, sf::Color(255, 255, 255, static_cast<sf::Uint8>(a * 255)));
             }
         }
     }
-}
 
-// Head-ground collision -> game over
-bool checkHeadHit(const Game& G) {
-    auto hp = G.car.headPos();
-    auto gs = sampleGround(hp.x, G.currentLevel);
-    return (hp.y >= gs.y - 3.0f); // small tolerance
-}
+    void buildLevel(int levelIndex) { layoutLevel(levelIndex, layers); }
+
+    // Procedural sprite placement for one level (deterministic per level);
+    // touches no GPU state, so it can run on a worker thread
+    static void layoutLevel(int levelIndex, ParallaxLayer (&layers)[LAYERS]) {
+        MemTagScope tag(MemRender);
+        FxRandom rng;
+        rng.state = 0x2545F491u + static_cast<sf::Uint32>(levelIndex) * 7919u;
+
+        const float scrolls[LAYERS] = { 0.05f, 0.15f, 0.30f, 0.50f };
+        const sf::Color tints[LAYERS] = { sf::Color(228, 228, 228), sf::Color(218, 218, 218),
+                                          sf::Color(200, 200, 200), sf::Color(175, 175, 175) };
+        for (int i = 0; i < LAYERS; i++) {
+            layers[i].scroll = scrolls[i];
+            layers[i].tint = tints[i];
+            layers[i].sprites.clear();
+        }
 
-// ---------------------------- Rendering -------------------------------
-void drawTerrain(sf::RenderWindow& win, const Game& G, float xStart, float xEnd) {
-    const float step = 8.0f; // px
-    sf::VertexArray strip(sf::TriangleStrip);
+        // Clouds drift high, hills are contiguous bands, trees are clustered
+        ParallaxLayer& clouds = layers[0];
+        clouds.period = 2.0f * WINDOW_W;
+        for (float x = rng.range(0.0f, 200.0f); x < clouds.period; x += rng.range(220.0f, 480.0f))
+            clouds.sprites.push_back({ x, rng.range(40.0f, 220.0f), rng.range(0.6f, 1.3f), AtlasCloud });
+
+        for (int i = 1; i <= 2; i++) {
+            ParallaxLayer& hills = layers[i];
+            float scale = (i == 1) ? 1.6f : 1.1f;
+            float tileW = ATLAS_RECTS[AtlasHills].width * scale;
+            int tiles = static_cast<int>(std::ceil(WINDOW_W / tileW)) + 1;
+            hills.period = tiles * tileW;
+            float y = WINDOW_H * ((i == 1) ? 0.38f : 0.50f) + rng.range(-20.0f, 20.0f);
+            for (int t = 0; t < tiles; t++)
+                hills.sprites.push_back({ t * tileW, y, scale, AtlasHills });
+        }
 
-    for (float x = xStart; x <= xEnd; x += step) {
-        auto gs = sampleGround(x, G.currentLevel);
-        strip.append(sf::Vertex(sf::Vector2f(x, gs.y), sf::Color::Black));
-        strip.append(sf::Vertex(sf::Vector2f(x, WINDOW_H), sf::Color::Black));
+        ParallaxLayer& trees = layers[3];
+        trees.period = 3.0f * WINDOW_W;
+        for (float x = 0.0f; x < trees.period; x += rng.range(60.0f, 420.0f))
+            trees.sprites.push_back({ x, WINDOW_H * 0.62f + rng.range(-10.0f, 15.0f), rng.range(0.7f, 1.2f), AtlasTree });
     }
 
-    win.draw(strip);
-}
-
-void drawVehicle(sf::RenderWindow& win, const Game& G) {
-    const Vehicle& V = G.car;
-
+    // Writes the visible sprites of every layer for the given camera center
+    void build(float camX, float camY) {
+        verts.clear();
+        for (const ParallaxLayer& L : layers) {
+            float shiftX = std::fmod(camX * L.scroll, L.period);
+            float shiftY = (camY - WINDOW_H * 0.5f) * L.scroll * 0.5f;
+            for (const ParallaxSprite& sp : L.sprites) {
+                const sf::IntRect& r = ATLAS_RECTS[sp.region];
+                float w = r.width * sp.scale, h = r.height * sp.scale;
+                float y = sp.y - shiftY;
+                // Repeat the layer period across the screen
+                for (float x = sp.x - shiftX - L.period; x < WINDOW_W; x += L.period) {
+                    if (x + w < 0.0f) continue;
+                    float u0 = static_cast<float>(r.left), v0 = static_cast<float>(r.top);
+                    float u1 = u0 + r.width, v1 = v0 + r.height;
+                    sf::Vertex a(sf::Vector2f(x, y), L.tint, sf::Vector2f(u0, v0));
+                    sf::Vertex b(sf::Vector2f(x + w, y), L.tint, sf::Vector2f(u1, v0));
+                    sf::Vertex c(sf::Vector2f(x + w, y + h), L.tint, sf::Vector2f(u1, v1));
+                    sf::Vertex d(sf::Vector2f(x, y + h), L.tint, sf::Vector2f(u0, v1));
+                    verts.push_back(a); verts.push_back(b); verts.push_back(c);
+                    verts.push_back(a); verts.push_back(c); verts.push_back(d);
+                    if (sp.region == AtlasHills && y + h < WINDOW_H) {
+                        // Extend the band to the bottom of the screen with the solid last row
+                        sf::Vertex e(sf::Vector2f(x + w, static_cast<float>(WINDOW_H)), L.tint, sf::Vector2f(u1, v1 - 1.0f));
+                        sf::Vertex f(sf::Vector2f(x, static_cast<float>(WINDOW_H)), L.tint, sf::Vector2f(u0, v1 - 1.0f));
+                        d.texCoords.y = c.texCoords.y = v1 - 1.0f;
+                        verts.push_back(d); verts.push_back(c); verts.push_back(e);
+                        verts.push_back(d); verts.push_back(e); verts.push_back(f);
+                    }
+                }
+            }
+        }
+    }
+};
+
+// ---------------------------- Terrain shader --------------------------
+// GPU terrain: one quad covering the visible range, filled below the surface by
+// a fragment shader that evaluates the same sine-sum as terrainHeight().
+// Phases are reduced with mod() before sin() so large x stay accurate on GPUs
+// with poor sin() range reduction.
+static const char* TERRAIN_VERT_SRC = R"(
+varying vec2 worldPos;
+void main() {
+    worldPos = gl_Vertex.xy;
+    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    gl_FrontColor = gl_Color;
+}
+)";
+
+static const char* TERRAIN_FRAG_SRC = R"(
+uniform float base;
+uniform float rough;
+uniform float freq1;
+uniform float freq2;
+uniform float pixelSize; // world px per screen pixel (edge anti-aliasing)
+varying vec2 worldPos;
+
+const float TWO_PI = 6.28318530718;
+float wave(float phase) { return sin(mod(phase, TWO_PI)); }
+
+void main() {
+    float x = worldPos.x;
+    float y = base
+        - rough * wave(x * freq1)
+        - 0.6 * rough * wave(x * freq2 + 1.7)
+        - 0.3 * rough * wave(x * (freq1 * 2.3) + 0.6);
+    float cover = clamp((worldPos.y - y) / pixelSize + 0.5, 0.0, 1.0);
+    if (cover <= 0.0) discard;
+    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * cover);
+}
+)";
+
+struct TerrainShader {
+    sf::Shader shader;
+    bool ready = false;
+    float maxError_px = 0.0f; // worst shader vs sampleGround mismatch found by verify()
+
+    void setParams(int levelIndex, float pixelSize) {
+        TerrainParams p = terrainParams(levelIndex);
+        shader.setUniform("base", p.base);
+        shader.setUniform("rough", p.rough);
+        shader.setUniform("freq1", p.freq1);
+        shader.setUniform("freq2", p.freq2);
+        shader.setUniform("pixelSize", pixelSize);
+    }
+
+    // Fills quad[4] with a world-space quad spanning [xStart, xEnd] x [yTop, yBottom]
+    static void makeQuad(sf::Vertex* quad, float xStart, float xEnd, float yTop, float yBottom) {
+        quad[0] = sf::Vertex(sf::Vector2f(xStart, yTop), sf::Color::Black);
+        quad[1] = sf::Vertex(sf::Vector2f(xStart, yBottom), sf::Color::Black);
+        quad[2] = sf::Vertex(sf::Vector2f(xEnd, yTop), sf::Color::Black);
+        quad[3] = sf::Vertex(sf::Vector2f(xEnd, yBottom), sf::Color::Black);
+    }
+
+    // Renders probe windows of every level at 1:1 scale and compares the first
+    // filled row of each column against the CPU terrain. Shader mode is only
+    // enabled when every column agrees within a pixel.
+    bool verify() {
+        const unsigned probeW = 256;
+        sf::RenderTexture rt;
+        if (!rt.create(probeW, WINDOW_H)) return false;
+
+        maxError_px = 0.0f;
+        for (int lvl = 0; lvl < 5; lvl++) {
+            float length_px = m2px(static_cast<float>(LEVEL_METERS[lvl]));
+            for (int probe = 0; probe < 4; probe++) {
+                float x0 = std::floor(length_px * probe / 4.0f);
+                rt.setView(sf::View(sf::FloatRect(x0, 0.0f, static_cast<float>(probeW), static_cast<float>(WINDOW_H))));
+                rt.clear(sf::Color::White);
+                sf::Vertex quad[4];
+                makeQuad(quad, x0, x0 + probeW, 0.0f, static_cast<float>(WINDOW_H));
+                setParams(lvl, 1.0f);
+                rt.draw(quad, 4, sf::TriangleStrip, &shader);
+                rt.display();
+
+                sf::Image img = rt.getTexture().copyToImage();
+                for (unsigned col = 0; col < probeW; col++) {
+                    unsigned row = 0;
+                    while (row < WINDOW_H && img.getPixel(col, row).r >= 128) row++;
+                    float cpuY = sampleGround(x0 + col + 0.5f, lvl).y;
+                    maxError_px = std::max(maxError_px, std::fabs(static_cast<float>(row) - cpuY));
+                }
+            }
+        }
+        return maxError_px <= 1.0f;
+    }
+
+    bool load() {
+        MemTagScope tag(MemRender);
+        ready = false;
+        if (!sf::Shader::isAvailable()) return false;
+        if (!shader.loadFromMemory(TERRAIN_VERT_SRC, TERRAIN_FRAG_SRC)) return false;
+        ready = verify();
+        std::cout << "Terrain shader max error vs CPU: " << std::fixed << std::setprecision(2)
+                  << maxError_px << " px" << (ready ? "" : " (disabled)") << std::endl;
+        return ready;
+    }
+};
+
+// ---------------------------- Frame pacing ----------------------------
+// Presents frames on a fixed schedule. The pacer sleeps until shortly before
+// the deadline and spins for the rest, with the spin margin tracking the
+// observed sleep overshoot. VSync mode leaves the wait to the driver. Both
+// modes record present-to-present intervals for the debug overlay.
+enum class PacingMode { Fixed, VSync };
+
+static const float TARGET_FPS = 120.0f;
+
+struct FramePacer {
+    static const int HISTORY = 240;
+
+    PacingMode mode = PacingMode::Fixed;
+    sf::Int64 period_us = static_cast<sf::Int64>(1000000.0f / TARGET_FPS + 0.5f);
+    sf::Clock clock;
+    sf::Int64 deadline_us = 0;
+    sf::Int64 lastPresent_us = -1;
+    sf::Int64 spinMargin_us = 1500;
+    float lastSwap_ms = 0.0f; // time spent inside display() for the last frame
+
+    float intervals_ms[HISTORY] = {};
+    int head = 0, filled = 0;
+
+    void setMode(sf::RenderWindow& win, PacingMode m) {
+        mode = m;
+        win.setVerticalSyncEnabled(mode == PacingMode::VSync);
+        deadline_us = clock.getElapsedTime().asMicroseconds() + period_us;
+        // Statistics restart: no interval spans the switch or mixes in the old mode
+        head = filled = 0;
+        lastPresent_us = -1;
+    }
+
+    void waitForDeadline() {
+        sf::Int64 now = clock.getElapsedTime().asMicroseconds();
+        sf::Int64 sleepFor = deadline_us - now - spinMargin_us;
+        if (sleepFor > 0) {
+            sf::sleep(sf::microseconds(sleepFor));
+            sf::Int64 overshoot = clock.getElapsedTime().asMicroseconds() - (now + sleepFor);
+            // Margin follows the worst recent overshoot, decaying slowly
+            spinMargin_us = std::max(spinMargin_us - spinMargin_us / 64, overshoot + 200);
+            spinMargin_us = std::min<sf::Int64>(std::max<sf::Int64>(spinMargin_us, 200), 4000);
+        }
+        while (clock.getElapsedTime().asMicroseconds() < deadline_us) {}
+    }
+
+    void present(sf::RenderWindow& win) {
+        if (mode == PacingMode::Fixed) waitForDeadline();
+        sf::Int64 swapStart = clock.getElapsedTime().asMicroseconds();
+        win.display();
+
+        sf::Int64 now = clock.getElapsedTime().asMicroseconds();
+        lastSwap_ms = (now - swapStart) / 1000.0f;
+        if (lastPresent_us >= 0) {
+            intervals_ms[head] = (now - lastPresent_us) / 1000.0f;
+            head = (head + 1) % HISTORY;
+            filled = std::min(filled + 1, HISTORY);
+        }
+        lastPresent_us = now;
+
+        // Next deadline; resynchronise instead of bursting after a long stall
+        deadline_us += period_us;
+        if (deadline_us < now) deadline_us = now + period_us;
+    }
+
+    // Part of the last display() that was GPU back-pressure. With vsync on,
+    // display() also waits for the vertical blank, which is idle time, so none
+    // of it is counted.
+    float swapLoad_ms() const { return mode == PacingMode::VSync ? 0.0f : lastSwap_ms; }
+
+    struct Stats { float mean_ms, stddev_ms, p99_ms, meanAbsError_ms; };
+    Stats stats() const {
+        Stats st = { 0.0f, 0.0f, 0.0f, 0.0f };
+        if (filled == 0) return st;
+        float sorted[HISTORY];
+        float target_ms = period_us / 1000.0f;
+        for (int i = 0; i < filled; i++) {
+            sorted[i] = intervals_ms[i];
+            st.mean_ms += intervals_ms[i];
+            st.meanAbsError_ms += std::fabs(intervals_ms[i] - target_ms);
+        }
+        st.mean_ms /= filled;
+        st.meanAbsError_ms /= filled;
+        for (int i = 0; i < filled; i++) st.stddev_ms += (sorted[i] - st.mean_ms) * (sorted[i] - st.mean_ms);
+        st.stddev_ms = std::sqrt(st.stddev_ms / filled);
+        int k = std::min(filled - 1, static_cast<int>(filled * 0.99f));
+        std::nth_element(sorted, sorted + k, sorted + filled);
+        st.p99_ms = sorted[k];
+        return st;
+    }
+};
+
+// ---------------------------- Dynamic resolution ----------------------
+// The playing scene is rendered into the top-left part of an offscreen
+// target and upscaled to the window. The fraction used follows a moving
+// average of the frame's render cost: the time to submit the scene plus the
+// time display() blocks, which grows when the GPU falls behind (SFML exposes
+// no GPU timer queries). Under vsync that block is mostly the wait for the
+// vertical blank, so only submit time counts there (FramePacer::swapLoad_ms).
+// The HUD is drawn afterwards at native resolution.
+static const float DYNRES_MIN_SCALE = 0.5f;
+static const float DYNRES_MAX_SCALE = 1.0f;
+static const int   DYNRES_SETTLE_FRAMES = 15; // frames between scale changes
+
+struct DynamicResolution {
+    sf::RenderTexture target;
+    bool ready = false;
+    float scale = 1.0f;
+    float target_ms = 8.0f; // frame-time target; <= 0 keeps full resolution
+    float avg_ms = 0.0f;
+    int framesSinceChange = 0;
+
+    bool create() {
+        MemTagScope tag(MemRender);
+        ready = target.create(WINDOW_W, WINDOW_H);
+        target.setSmooth(true);
+        return ready;
+    }
+
+    sf::FloatRect viewport() const { return sf::FloatRect(0.0f, 0.0f, scale, scale); }
+
+    void record(float frame_ms) {
+        avg_ms += (frame_ms - avg_ms) * 0.1f;
+        if (target_ms <= 0.0f || ++framesSinceChange < DYNRES_SETTLE_FRAMES) return;
+
+        float next = scale;
+        if (avg_ms > target_ms) next = scale - 0.05f;
+        else if (avg_ms < target_ms * 0.8f) next = scale + 0.025f;
+        next = clampf(next, DYNRES_MIN_SCALE, DYNRES_MAX_SCALE);
+        if (next != scale) {
+            scale = next;
+            framesSinceChange = 0;
+        }
+    }
+
+    // Upscales the rendered part of the target to the full window
+    void blit(sf::RenderWindow& win) {
+        target.display();
+        sf::Sprite sprite(target.getTexture(), sf::IntRect(0, 0,
+            static_cast<int>(WINDOW_W * scale), static_cast<int>(WINDOW_H * scale)));
+        sprite.setScale(1.0f / scale, 1.0f / scale);
+        win.setView(win.getDefaultView());
+        win.draw(sprite);
+    }
+};
+
+// ---------------------------- Capture ---------------------------------
+// Gameplay capture without pipeline stalls. Frames are read back with
+// glReadPixels into a ring of pixel buffer objects and mapped CAPTURE_RING - 1
+// captures later, when the copy has long completed. Mapped pixels are copied
+// into a fixed pool of frame slots and handed to encoder threads, which either
+// pipe raw RGBA into an external encoder or write a PNG image sequence. If the
+// encoders fall behind, frames are dropped and counted instead of blocking;
+// stopping still waits for the readbacks in flight, so no frame is cut off.
+// The encoder command (--capture-cmd) is run as given, with {w} and {h}
+// replaced by the frame size; nothing else in it is interpreted.
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+static const int   CAPTURE_RING = 3;   // PBOs in flight
+static const int   CAPTURE_SLOTS = 12; // encoder backlog, in frames
+static const float CAPTURE_FPS = 60.0f;
+static const char* CAPTURE_DEFAULT_CMD =
+    "ffmpeg -loglevel error -y -f rawvideo -pix_fmt rgba -s {w}x{h} -r 60 -i - "
+    "-vf vflip -c:v libx264 -preset ultrafast -pix_fmt yuv420p capture.mp4";
+
+// The encoder command with every {w} and {h} replaced by the frame size
+std::string captureCommandLine(const std::string& command, unsigned width, unsigned height) {
+    std::string line;
+    for (size_t i = 0; i < command.size();) {
+        if (command.compare(i, 3, "{w}") == 0) { line += std::to_string(width); i += 3; }
+        else if (command.compare(i, 3, "{h}") == 0) { line += std::to_string(height); i += 3; }
+        else line += command[i++];
+    }
+    return line;
+}
+
+struct PboFunctions {
+    typedef void (APIENTRY* GenBuffers)(GLsizei, GLuint*);
+    typedef void (APIENTRY* DeleteBuffers)(GLsizei, const GLuint*);
+    typedef void (APIENTRY* BindBuffer)(GLenum, GLuint);
+    typedef void (APIENTRY* BufferData)(GLenum, std::ptrdiff_t, const void*, GLenum);
+    typedef void* (APIENTRY* MapBuffer)(GLenum, GLenum);
+    typedef GLboolean (APIENTRY* UnmapBuffer)(GLenum);
+
+    GenBuffers genBuffers = nullptr;
+    DeleteBuffers deleteBuffers = nullptr;
+    BindBuffer bindBuffer = nullptr;
+    BufferData bufferData = nullptr;
+    MapBuffer mapBuffer = nullptr;
+    UnmapBuffer unmapBuffer = nullptr;
+
+    bool load() {
+        genBuffers = reinterpret_cast<GenBuffers>(sf::Context::getFunction("glGenBuffers"));
+        deleteBuffers = reinterpret_cast<DeleteBuffers>(sf::Context::getFunction("glDeleteBuffers"));
+        bindBuffer = reinterpret_cast<BindBuffer>(sf::Context::getFunction("glBindBuffer"));
+        bufferData = reinterpret_cast<BufferData>(sf::Context::getFunction("glBufferData"));
+        mapBuffer = reinterpret_cast<MapBuffer>(sf::Context::getFunction("glMapBuffer"));
+        unmapBuffer = reinterpret_cast<UnmapBuffer>(sf::Context::getFunction("glUnmapBuffer"));
+        return genBuffers && deleteBuffers && bindBuffer && bufferData && mapBuffer && unmapBuffer;
+    }
+};
+
+struct FrameCapture {
+    bool active = false;
+    std::string command;   // encoder command line; empty writes an image sequence
+    std::string directory = "capture";
+
+    unsigned width = 0, height = 0;
+    PboFunctions gl;
+    GLuint pbo[CAPTURE_RING] = {};
+    int issued = 0;        // readbacks issued since start()
+    sf::Clock clock;
+    float nextCapture_s = 0.0f;
+
+    // Frame slots shared with the encoder threads
+    struct Slot { std::vector<sf::Uint8> pixels; int frame = 0; };
+    Slot slots[CAPTURE_SLOTS];
+    std::vector<int> freeSlots, readySlots; // capacity reserved in start()
+    std::mutex mutex;
+    std::condition_variable wake, freed; // ready slots for the encoders; a slot back in the pool
+    std::vector<std::thread> workers;
+    bool stopping = false;
+    FILE* pipe = nullptr;
+
+    int framesQueued = 0, framesDropped = 0;
+    std::atomic<int> framesWritten{ 0 };
+
+    // Game outlives the window, so its GL context is gone by now: the main
+    // loop stops capture before closing, and this only joins the encoders
+    ~FrameCapture() { stop(false); }
+
+    bool start(const sf::RenderWindow& win) {
+        if (active) return true;
+        MemTagScope tag(MemTelemetry);
+        if (!gl.load()) {
+            std::cout << "Capture unavailable: no pixel buffer object support" << std::endl;
+            return false;
+        }
+        width = win.getSize().x;
+        height = win.getSize().y;
+        size_t bytes = static_cast<size_t>(width) * height * 4;
+
+        gl.genBuffers(CAPTURE_RING, pbo);
+        for (GLuint b : pbo) {
+            gl.bindBuffer(GL_PIXEL_PACK_BUFFER, b);
+            gl.bufferData(GL_PIXEL_PACK_BUFFER, static_cast<std::ptrdiff_t>(bytes), nullptr, GL_STREAM_READ);
+        }
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        freeSlots.clear(); readySlots.clear();
+        freeSlots.reserve(CAPTURE_SLOTS); readySlots.reserve(CAPTURE_SLOTS);
+        for (int i = 0; i < CAPTURE_SLOTS; i++) {
+            slots[i].pixels.resize(bytes);
+            freeSlots.push_back(i);
+        }
+
+        int encoders = 1;
+        if (command.empty()) std::filesystem::create_directories(directory);
+        else {
+            std::string cmd = captureCommandLine(command, width, height);
+#ifdef _WIN32
+            pipe = _popen(cmd.c_str(), "wb");
+#else
+            pipe = popen(cmd.c_str(), "w");
+#endif
+            if (!pipe) {
+                std::cout << "Capture: could not start encoder, writing images to " << directory << "/" << std::endl;
+                std::filesystem::create_directories(directory);
+            }
+        }
+        if (!pipe) encoders = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+        stopping = false;
+        issued = 0;
+        framesQueued = framesDropped = framesWritten = 0;
+        nextCapture_s = 0.0f;
+        clock.restart();
+        for (int i = 0; i < encoders; i++) workers.emplace_back(&FrameCapture::encodeLoop, this);
+        active = true;
+        return true;
+    }
+
+    // contextAlive: the window's GL context is still current, so the PBOs can be released
+    void stop(bool contextAlive = true) {
+        if (!active) return;
+        if (contextAlive) {
+            // The last CAPTURE_RING - 1 readbacks are still in flight; queue them too
+            for (int k = std::max(0, issued - (CAPTURE_RING - 1)); k < issued; k++)
+                collect(pbo[k % CAPTURE_RING], true);
+            gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+        workers.clear();
+        if (pipe) {
+#ifdef _WIN32
+            _pclose(pipe);
+#else
+            pclose(pipe);
+#endif
+            pipe = nullptr;
+        }
+        if (contextAlive) gl.deleteBuffers(CAPTURE_RING, pbo);
+        active = false;
+        std::cout << "Capture: " << framesWritten.load() << " frames written, " << framesDropped << " dropped" << std::endl;
+    }
+
+    // Call with the finished frame in the back buffer, before display()
+    void onFrame() {
+        if (!active) return;
+        float now = clock.getElapsedTime().asSeconds();
+        if (now < nextCapture_s) return;
+        nextCapture_s = std::max(nextCapture_s + 1.0f / CAPTURE_FPS, now - 0.5f / CAPTURE_FPS);
+
+        // Issue this frame's readback; it completes asynchronously into the PBO
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo[issued % CAPTURE_RING]);
+        glReadPixels(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        issued++;
+
+        // Collect the oldest readback still in flight
+        if (issued >= CAPTURE_RING) collect(pbo[issued % CAPTURE_RING], false);
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // Maps a finished readback and hands it to the encoders. While playing a
+    // frame with no free slot is dropped; when stopping, waitForSlot blocks
+    // until an encoder frees one.
+    void collect(GLuint buffer, bool waitForSlot) {
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        const void* data = gl.mapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (!data) {
+            framesDropped++;
+            return;
+        }
+        int slot = -1;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (waitForSlot) freed.wait(lock, [&] { return !freeSlots.empty(); });
+            if (!freeSlots.empty()) { slot = freeSlots.back(); freeSlots.pop_back(); }
+        }
+        if (slot >= 0) {
+            std::memcpy(slots[slot].pixels.data(), data, slots[slot].pixels.size());
+            slots[slot].frame = framesQueued++;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                readySlots.push_back(slot);
+            }
+            wake.notify_one();
+        }
+        else {
+            framesDropped++;
+        }
+        gl.unmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    void encodeLoop() {
+        sf::Image image;
+        for (;;) {
+            int slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || !readySlots.empty(); });
+                if (readySlots.empty()) return; // stopping and drained
+                slot = readySlots.front();
+                readySlots.erase(readySlots.begin()); // FIFO keeps piped frames in order
+            }
+
+            Slot& sl = slots[slot];
+            if (pipe) {
+                std::fwrite(sl.pixels.data(), 1, sl.pixels.size(), pipe);
+            }
+            else {
+                // glReadPixels rows are bottom-up
+                image.create(width, height, sl.pixels.data());
+                image.flipVertically();
+                char name[256];
+                std::snprintf(name, sizeof(name), "%s/frame_%06d.png", directory.c_str(), sl.frame);
+                image.saveToFile(name);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            framesWritten++;
+            freeSlots.push_back(slot);
+            freed.notify_one();
+        }
+    }
+};
+
+// ---------------------------- Level thumbnails ------------------------
+// Level overview images are rendered offline (--render-overviews) and only
+// loaded here. The Game Over screen shows the level a retry starts; Level
+// Complete shows the next level once it is unlocked.
+static const unsigned OVERVIEW_W = 1600;
+static const unsigned OVERVIEW_H = 160;
+static const char* OVERVIEW_DIR = "overviews";
+
+std::string overviewPath(const std::string& dir, int levelIndex) {
+    return dir + "/level_" + std::to_string(levelIndex + 1) + ".png";
+}
+
+// Pre-rendered overviews for the result screens; missing files are skipped
+struct LevelThumbnails {
+    sf::Texture textures[5];
+    bool loaded[5] = {};
+    sf::Image images[5]; // decoded, awaiting upload
+    bool decoded[5] = {};
+
+    void load(const std::string& dir) {
+        decode(dir);
+        upload();
+    }
+
+    // Reads and decodes the images; no GL, so it can run on a worker thread
+    void decode(const std::string& dir) {
+        MemTagScope tag(MemRender);
+        for (int i = 0; i < 5; i++) decoded[i] = images[i].loadFromFile(overviewPath(dir, i));
+    }
+
+    void upload() {
+        MemTagScope tag(MemRender);
+        for (int i = 0; i < 5; i++) {
+            loaded[i] = decoded[i] && textures[i].loadFromImage(images[i]);
+            if (loaded[i]) textures[i].setSmooth(true);
+            images[i] = sf::Image();
+            decoded[i] = false;
+        }
+    }
+
+    void draw(sf::RenderTarget& win, int levelIndex, float x, float y, float w, float h) const {
+        if (levelIndex < 0 || levelIndex >= 5 || !loaded[levelIndex]) return;
+        sf::Sprite sprite(textures[levelIndex]);
+        sprite.setPosition(x, y);
+        sprite.setScale(w / textures[levelIndex].getSize().x, h / textures[levelIndex].getSize().y);
+        win.draw(sprite);
+    }
+};
+
+// ---------------------------- Input -----------------------------------
+// Driving input is sampled on its own thread at ~1 kHz and queued with
+// arrival timestamps through a lock-free single-producer/single-consumer ring.
+// Each fixed physics step applies exactly the transitions that arrived before
+// the step's end, so control timing follows the 120 Hz physics rate instead of
+// the render rate. Applied transitions are recorded by physics tick; the log is
+// only a recording, nothing plays it back.
+static const sf::Int64 INPUT_SAMPLE_US = 1000;
+static const size_t    INPUT_LOG_CAPACITY = 1 << 16; // transitions recorded per run
+
+// Microseconds on a steady clock shared by all threads
+inline sf::Int64 nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename T, size_t N>
+struct SpscQueue {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+    T items[N];
+    alignas(64) std::atomic<size_t> head{ 0 }; // next slot to read (consumer)
+    alignas(64) std::atomic<size_t> tail{ 0 }; // next slot to write (producer)
+
+    bool push(const T& v) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) return false;
+        items[t & (N - 1)] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool peek(T& out) const {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        out = items[h & (N - 1)];
+        return true;
+    }
+    void pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+};
+
+enum InputControl : sf::Uint8 { InputLeft, InputRight, InputControlCount };
+
+struct InputEvent {
+    sf::Int64 time_us;
+    sf::Uint8 control;
+    bool pressed;
+};
+
+// Applied transition, keyed by the physics tick that consumed it
+struct InputRecord {
+    sf::Uint32 tick;
+    sf::Uint8 control;
+    bool pressed;
+};
+
+struct InputSampler {
+    SpscQueue<InputEvent, 256> queue;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> focused{ true };
+    std::atomic<bool> held[InputControlCount] = {}; // state as of the last transition queued
+    std::thread thread;
+    int dropped = 0; // producer-side count of events lost to a full queue
+
+    ~InputSampler() { stop(); }
+
+    void start() {
+        if (running.exchange(true)) return;
+        thread = std::thread(&InputSampler::run, this);
+    }
+
+    void stop() {
+        if (!running.exchange(false)) return;
+        thread.join();
+    }
+
+    void run() {
+        while (running.load(std::memory_order_relaxed)) {
+            bool hasFocus = focused.load(std::memory_order_relaxed);
+            bool now[InputControlCount] = {
+                hasFocus && (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) || sf::Keyboard::isKeyPressed(sf::Keyboard::A)),
+                hasFocus && (sf::Keyboard::isKeyPressed(sf::Keyboard::Right) || sf::Keyboard::isKeyPressed(sf::Keyboard::D)),
+            };
+            sf::Int64 t = nowUs();
+            for (sf::Uint8 c = 0; c < InputControlCount; c++) {
+                if (now[c] == held[c].load(std::memory_order_relaxed)) continue;
+                if (queue.push({ t, c, now[c] })) held[c].store(now[c], std::memory_order_release);
+                else dropped++;
+            }
+            sf::sleep(sf::microseconds(INPUT_SAMPLE_US));
+        }
+    }
+};
+
+// ---------------------------- Latency probe ---------------------------
+// Diagnostic mode (F8) following each driving input to the screen. An input
+// is stamped on arrival (sampler), when a physics step consumes it, when that
+// step finishes, when the first frame containing its effect has been
+// submitted, and when that frame's display() has completed on the GPU
+// (glFinish, so this mode slightly perturbs what it measures).
+static const int LATENCY_IN_FLIGHT = 32;
+static const int LATENCY_HISTORY = 512;
+
+struct LatencyProbe {
+    enum Stage { Queue, Simulate, Render, Present, Total, StageCount };
+
+    struct Pending { sf::Int64 arrived, consumed, simulated, rendered; };
+
+    bool enabled = false;
+    Pending pending[LATENCY_IN_FLIGHT];
+    int pendingCount = 0;
+
+    float samples_ms[StageCount][LATENCY_HISTORY] = {};
+    int head = 0, filled = 0;
+
+    void setEnabled(bool on) {
+        enabled = on;
+        pendingCount = 0;
+        if (!on) report();
+    }
+
+    void onConsumed(sf::Int64 arrived_us) {
+        if (!enabled || pendingCount == LATENCY_IN_FLIGHT) return;
+        pending[pendingCount++] = { arrived_us, nowUs(), 0, 0 };
+    }
+
+    void onStepDone() {
+        if (!enabled) return;
+        sf::Int64 t = nowUs();
+        for (int i = 0; i < pendingCount; i++)
+            if (pending[i].simulated == 0) pending[i].simulated = t;
+    }
+
+    void onFrameSubmitted() {
+        if (!enabled) return;
+        sf::Int64 t = nowUs();
+        for (int i = 0; i < pendingCount; i++)
+            if (pending[i].simulated != 0 && pending[i].rendered == 0) pending[i].rendered = t;
+    }
+
+    void onFramePresented() {
+        if (!enabled || pendingCount == 0) return;
+        glFinish();
+        sf::Int64 t = nowUs();
+        int kept = 0;
+        for (int i = 0; i < pendingCount; i++) {
+            const Pending& p = pending[i];
+            if (p.rendered == 0) { pending[kept++] = p; continue; }
+            samples_ms[Queue][head] = (p.consumed - p.arrived) / 1000.0f;
+            samples_ms[Simulate][head] = (p.simulated - p.consumed) / 1000.0f;
+            samples_ms[Render][head] = (p.rendered - p.simulated) / 1000.0f;
+            samples_ms[Present][head] = (t - p.rendered) / 1000.0f;
+            samples_ms[Total][head] = (t - p.arrived) / 1000.0f;
+            head = (head + 1) % LATENCY_HISTORY;
+            filled = std::min(filled + 1, LATENCY_HISTORY);
+        }
+        pendingCount = kept;
+    }
+
+    // p = 0.50 / 0.95 / 0.99
+    float percentile(Stage stage, float p) const {
+        if (filled == 0) return 0.0f;
+        float sorted[LATENCY_HISTORY];
+        std::copy(samples_ms[stage], samples_ms[stage] + filled, sorted);
+        int k = std::min(filled - 1, static_cast<int>(filled * p));
+        std::nth_element(sorted, sorted + k, sorted + filled);
+        return sorted[k];
+    }
+
+    void report() const {
+        if (filled == 0) return;
+        static const char* names[StageCount] = { "queue", "simulate", "render", "present", "total" };
+        std::cout << "Input latency over " << filled << " inputs (ms, p50/p95/p99):" << std::endl;
+        for (int st = 0; st < StageCount; st++) {
+            std::cout << "  " << std::setw(9) << names[st] << std::fixed << std::setprecision(2)
+                      << "  " << percentile(static_cast<Stage>(st), 0.50f)
+                      << " / " << percentile(static_cast<Stage>(st), 0.95f)
+                      << " / " << percentile(static_cast<Stage>(st), 0.99f) << std::endl;
+        }
+    }
+};
+
+// ---------------------------- Startup profile -------------------------
+// Startup phases timed from process start (main() constructs the profile
+// first). Worker threads record their own phases.
+struct StartupProfile {
+    struct Phase { const char* name; double begin_ms, end_ms; bool worker; };
+    sf::Clock clock;
+    mutable std::mutex mutex;
+    std::vector<Phase> phases;
+    double interactive_ms = -1.0; // first menu frame presented with its widgets
+
+    double now_ms() const { return clock.getElapsedTime().asMicroseconds() / 1000.0; }
+
+    void record(const char* name, double begin_ms, bool worker) {
+        double end = now_ms();
+        std::lock_guard<std::mutex> lock(mutex);
+        phases.push_back({ name, begin_ms, end, worker });
+    }
+
+    template <typename F>
+    void time(const char* name, bool worker, F&& work) {
+        double begin = now_ms();
+        work();
+        record(name, begin, worker);
+    }
+
+    void report() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Phase> sorted = phases;
+        std::sort(sorted.begin(), sorted.end(), [](const Phase& a, const Phase& b) { return a.begin_ms < b.begin_ms; });
+        double busy = 0.0, end = 0.0;
+        std::cout << "Startup phases (ms from process start):" << std::endl;
+        for (const Phase& p : sorted) {
+            std::cout << "  " << std::left << std::setw(18) << p.name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(8) << p.begin_ms << " .. " << std::setw(8) << p.end_ms
+                      << "  (" << std::setw(6) << p.end_ms - p.begin_ms << ")" << (p.worker ? "  worker" : "") << std::endl;
+            busy += p.end_ms - p.begin_ms;
+            end = std::max(end, p.end_ms);
+        }
+        std::cout << "  time to interactive " << interactive_ms << " ms, all phases done " << end
+                  << " ms, " << busy << " ms of work" << std::endl;
+    }
+};
+
+// ---------------------------- UI --------------------------------------
+// Each menu screen is a retained list of widgets built once from a layout
+// table. The same widgets are drawn and hit-tested. Hit-testing uses a
+// slab index: interactive widgets are bucketed into horizontal bands between
+// their sorted top/bottom edges, and each band is sorted by x. A click is two
+// binary searches and allocates nothing.
+enum class UiAction { None, Play, Exit, PrevLevel, Retry, NextLevel, MainMenu, Daily };
+enum class WidgetKind { Label, Button, Arrow, Region };
+
+struct WidgetDesc {
+    WidgetKind kind;
+    UiAction action;
+    const char* text;    // nullptr: use glyph
+    sf::Uint32 glyph;
+    unsigned charSize;
+    float x, y;          // x < 0 centers horizontally
+    float w, h;          // buttons and regions only
+};
+
+static const sf::Uint32 GLYPH_LEFT_ARROW = 0x2190;
+static const sf::Uint32 GLYPH_RIGHT_ARROW = 0x2192;
+static const int UI_STATS_LABEL = 1; // result screens keep their stats label at index 1
+static const int MENU_DAILY_LABEL = 4;
+
+static const WidgetDesc MENU_LAYOUT[] = {
+    { WidgetKind::Label,  UiAction::None, "Black And White Racing", 0, 42, -1.0f, 80.0f, 0.0f, 0.0f },
+    { WidgetKind::Button, UiAction::Play, "Play", 0, 24, (WINDOW_W - 200.0f) / 2, (WINDOW_H - 50.0f * 3 - 20.0f * 2) / 2, 200.0f, 50.0f },
+    { WidgetKind::Button, UiAction::Daily, "Daily", 0, 24, (WINDOW_W - 200.0f) / 2, (WINDOW_H - 50.0f * 3 - 20.0f * 2) / 2 + 70.0f, 200.0f, 50.0f },
+    { WidgetKind::Button, UiAction::Exit, "Exit", 0, 24, (WINDOW_W - 200.0f) / 2, (WINDOW_H - 50.0f * 3 - 20.0f * 2) / 2 + 140.0f, 200.0f, 50.0f },
+    { WidgetKind::Label,  UiAction::None, "", 0, 22, -1.0f, 620.0f, 0.0f, 0.0f },
+};
+
+// Without a font: click top half to play, bottom half to exit
+static const WidgetDesc MENU_FALLBACK_LAYOUT[] = {
+    { WidgetKind::Region, UiAction::Play, nullptr, 0, 0, 0.0f, 0.0f, static_cast<float>(WINDOW_W), WINDOW_H / 2.0f },
+    { WidgetKind::Region, UiAction::Exit, nullptr, 0, 0, 0.0f, WINDOW_H / 2.0f, static_cast<float>(WINDOW_W), WINDOW_H / 2.0f },
+};
+
+static const WidgetDesc GAME_OVER_LAYOUT[] = {
+    { WidgetKind::Label,  UiAction::None, "Game Over", 0, 48, -1.0f, 80.0f, 0.0f, 0.0f },
+    { WidgetKind::Label,  UiAction::None, "", 0, 28, -1.0f, 160.0f, 0.0f, 0.0f },
+    { WidgetKind::Arrow,  UiAction::PrevLevel, nullptr, GLYPH_LEFT_ARROW, 60, 300.0f, 350.0f, 0.0f, 0.0f },
+    { WidgetKind::Button, UiAction::Retry, "Retry", 0, 24, 540.0f, 350.0f, 200.0f, 50.0f },
+    { WidgetKind::Button, UiAction::MainMenu, "Exit", 0, 24, 540.0f, 500.0f, 200.0f, 50.0f },
+    { WidgetKind::Label,  UiAction::None, "Left/Right: Change Level   R: Restart   Backspace: Main Menu", 0, 22, -1.0f, 620.0f, 0.0f, 0.0f },
+};
+
+static const WidgetDesc LEVEL_COMPLETE_LAYOUT[] = {
+    { WidgetKind::Label,  UiAction::None, "Level Complete!", 0, 48, -1.0f, 80.0f, 0.0f, 0.0f },
+    { WidgetKind::Label,  UiAction::None, "", 0, 28, -1.0f, 160.0f, 0.0f, 0.0f },
+    { WidgetKind::Arrow,  UiAction::PrevLevel, nullptr, GLYPH_LEFT_ARROW, 60, 300.0f, 350.0f, 0.0f, 0.0f },
+    { WidgetKind::Arrow,  UiAction::NextLevel, nullptr, GLYPH_RIGHT_ARROW, 60, 900.0f, 350.0f, 0.0f, 0.0f },
+    { WidgetKind::Button, UiAction::Retry, "Retry", 0, 24, 540.0f, 350.0f, 200.0f, 50.0f },
+    { WidgetKind::Button, UiAction::MainMenu, "Exit", 0, 24, 540.0f, 500.0f, 200.0f, 50.0f },
+    { WidgetKind::Label,  UiAction::None, "Left/Right: Change Level   R: Restart   Backspace: Main Menu", 0, 22, -1.0f, 620.0f, 0.0f, 0.0f },
+};
+
+static const WidgetDesc GAME_COMPLETED_LAYOUT[] = {
+    { WidgetKind::Label,  UiAction::None, "Game Completed!", 0, 48, -1.0f, 80.0f, 0.0f, 0.0f },
+    { WidgetKind::Label,  UiAction::None, "", 0, 28, -1.0f, 160.0f, 0.0f, 0.0f },
+    { WidgetKind::Button, UiAction::MainMenu, "Exit", 0, 24, (WINDOW_W - 200.0f) / 2, 350.0f, 200.0f, 50.0f },
+    { WidgetKind::Label,  UiAction::None, "Backspace: Main Menu", 0, 22, -1.0f, 620.0f, 0.0f, 0.0f },
+};
+
+static const WidgetDesc DAILY_RESULT_LAYOUT[] = {
+    { WidgetKind::Label,  UiAction::None, "Daily Challenge", 0, 48, -1.0f, 80.0f, 0.0f, 0.0f },
+    { WidgetKind::Label,  UiAction::None, "", 0, 28, -1.0f, 160.0f, 0.0f, 0.0f },
+    { WidgetKind::Button, UiAction::Retry, "Retry", 0, 24, 540.0f, 350.0f, 200.0f, 50.0f },
+    { WidgetKind::Button, UiAction::MainMenu, "Exit", 0, 24, 540.0f, 500.0f, 200.0f, 50.0f },
+    { WidgetKind::Label,  UiAction::None, "R: Restart   Backspace: Main Menu", 0, 22, -1.0f, 620.0f, 0.0f, 0.0f },
+};
+
+struct Widget {
+    WidgetKind kind = WidgetKind::Label;
+    UiAction action = UiAction::None;
+    sf::FloatRect bounds;
+    sf::RectangleShape rect;
+    sf::Text text;
+    std::string label; // current label string, so unchanged labels aren't re-laid out
+};
+
+struct UiScreen {
+    std::vector<Widget> widgets;
+    std::vector<float> slabTop;     // sorted band edges
+    std::vector<int> slabBegin;     // band i covers slabItems[slabBegin[i], slabBegin[i + 1])
+    std::vector<int> slabItems;     // widget indices, sorted by bounds.left within a band
+
+    static void centerLabel(Widget& w) {
+        sf::FloatRect b = w.text.getLocalBounds();
+        w.text.setPosition((WINDOW_W - b.width) / 2, w.text.getPosition().y);
+        w.bounds = w.text.getGlobalBounds();
+    }
+
+    void build(const WidgetDesc* desc, size_t count, const sf::Font* font) {
+        MemTagScope tag(MemRender);
+        widgets.clear();
+        widgets.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const WidgetDesc& d = desc[i];
+            Widget& w = widgets[i];
+            w.kind = d.kind;
+            w.action = d.action;
+            if (font && d.kind != WidgetKind::Region) {
+                w.text.setFont(*font);
+                w.text.setCharacterSize(d.charSize);
+                if (d.text) {
+                    w.label = d.text;
+                    w.text.setString(d.text);
+                }
+                else {
+                    w.text.setString(sf::String(d.glyph));
+                }
+            }
+
+            switch (d.kind) {
+            case WidgetKind::Button: {
+                w.rect.setSize(sf::Vector2f(d.w, d.h));
+                w.rect.setPosition(d.x, d.y);
+                w.rect.setOutlineColor(sf::Color::Black);
+                w.rect.setOutlineThickness(2.0f);
+                w.text.setFillColor(sf::Color::White);
+                sf::FloatRect tb = w.text.getLocalBounds();
+                w.text.setPosition(d.x + (d.w - tb.width) / 2, d.y + (d.h - tb.height) / 2 - tb.top);
+                w.bounds = w.rect.getGlobalBounds();
+                break;
+            }
+            case WidgetKind::Region:
+                w.bounds = sf::FloatRect(d.x, d.y, d.w, d.h);
+                break;
+            default:
+                w.text.setFillColor(sf::Color::Black);
+                w.text.setPosition(d.x < 0.0f ? 0.0f : d.x, d.y);
+                if (d.x < 0.0f) centerLabel(w);
+                w.bounds = w.text.getGlobalBounds();
+                break;
+            }
+        }
+        buildIndex();
+    }
+
+    void buildIndex() {
+        slabTop.clear(); slabBegin.clear(); slabItems.clear();
+        for (const Widget& w : widgets) {
+            if (w.action == UiAction::None) continue;
+            slabTop.push_back(w.bounds.top);
+            slabTop.push_back(w.bounds.top + w.bounds.height);
+        }
+        std::sort(slabTop.begin(), slabTop.end());
+        slabTop.erase(std::unique(slabTop.begin(), slabTop.end()), slabTop.end());
+
+        for (size_t b = 0; b + 1 < slabTop.size(); b++) {
+            slabBegin.push_back(static_cast<int>(slabItems.size()));
+            size_t first = slabItems.size();
+            for (size_t i = 0; i < widgets.size(); i++) {
+                const sf::FloatRect& r = widgets[i].bounds;
+                if (widgets[i].action != UiAction::None && r.top <= slabTop[b] && r.top + r.height >= slabTop[b + 1])
+                    slabItems.push_back(static_cast<int>(i));
+            }
+            std::sort(slabItems.begin() + first, slabItems.end(),
+                [&](int a, int c) { return widgets[a].bounds.left < widgets[c].bounds.left; });
+        }
+        slabBegin.push_back(static_cast<int>(slabItems.size()));
+    }
+
+    // Index of the interactive widget under p, or -1
+    int hitTest(sf::Vector2f p) const {
+        if (slabTop.size() < 2 || p.y < slabTop.front() || p.y >= slabTop.back()) return -1;
+        size_t band = static_cast<size_t>(std::upper_bound(slabTop.begin(), slabTop.end(), p.y) - slabTop.begin()) - 1;
+        auto first = slabItems.begin() + slabBegin[band], last = slabItems.begin() + slabBegin[band + 1];
+        auto it = std::upper_bound(first, last, p.x,
+            [&](float x, int i) { return x < widgets[i].bounds.left; });
+        if (it == first) return -1;
+        int i = *(it - 1);
+        return widgets[i].bounds.contains(p) ? i : -1;
+    }
+
+    UiAction actionAt(sf::Vector2f p) const {
+        int i = hitTest(p);
+        return i >= 0 ? widgets[i].action : UiAction::None;
+    }
+
+    // Replaces a centered label's text; re-lays it out only when it changed
+    void setLabel(int index, const char* str) {
+        if (index >= static_cast<int>(widgets.size())) return;
+        Widget& w = widgets[index];
+        if (w.label == str) return;
+        w.label = str;
+        w.text.setString(str);
+        centerLabel(w);
+    }
+
+    void draw(sf::RenderTarget& win, sf::Vector2f mouse) {
+        int hovered = hitTest(mouse);
+        for (size_t i = 0; i < widgets.size(); i++) {
+            Widget& w = widgets[i];
+            bool hot = static_cast<int>(i) == hovered;
+            switch (w.kind) {
+            case WidgetKind::Button:
+                w.rect.setFillColor(hot ? sf::Color(0, 80, 200) : sf::Color(0, 120, 255));
+                win.draw(w.rect);
+                win.draw(w.text);
+                break;
+            case WidgetKind::Arrow:
+                w.text.setFillColor(hot ? sf::Color::Red : sf::Color::Black);
+                win.draw(w.text);
+                break;
+            case WidgetKind::Label:
+                win.draw(w.text);
+                break;
+            case WidgetKind::Region:
+                break;
+            }
+        }
+    }
+};
+
+// Per-frame text (HUD, F3 overlay) is laid out as glyph quads in a reused
+// vertex buffer and drawn with the font's page texture, so changing numbers
+// don't construct sf::String/sf::Text geometry every frame. Glyphs are loaded
+// up front (Game::prewarmGlyphs) so frames never rasterize new ones.
+struct TextBatch {
+    const sf::Font* font = nullptr;
+    unsigned charSize = 18;
+    sf::Color color = sf::Color::Black;
+    std::vector<sf::Vertex> verts;
+    float width = 0.0f; // widest line of the last layout
+
+    void setup(const sf::Font& f, unsigned size, sf::Color c, size_t maxChars) {
+        MemTagScope tag(MemRender);
+        font = &f;
+        charSize = size;
+        color = c;
+        verts.reserve(maxChars * 6);
+    }
+
+    // Lays str out with its top-left at (x, y), matching sf::Text placement
+    void layout(const char* str, float x, float y) {
+        verts.clear();
+        width = 0.0f;
+        if (!font) return;
+        const float padding = 1.0f; // as sf::Text, so glyph edges aren't clipped
+        float lineSpacing = font->getLineSpacing(charSize);
+        float penX = x, baseline = y + charSize;
+        sf::Uint32 prev = 0;
+        for (const char* p = str; *p; p++) {
+            sf::Uint32 ch = static_cast<unsigned char>(*p);
+            if (ch == '\n') {
+                width = std::max(width, penX - x);
+                penX = x;
+                baseline += lineSpacing;
+                prev = 0;
+                continue;
+            }
+            penX += font->getKerning(prev, ch, charSize);
+            prev = ch;
+            const sf::Glyph& g = font->getGlyph(ch, charSize, false);
+            if (ch != ' ') {
+                float l = penX + g.bounds.left - padding, t = baseline + g.bounds.top - padding;
+                float r = penX + g.bounds.left + g.bounds.width + padding, b = baseline + g.bounds.top + g.bounds.height + padding;
+                float u0 = g.textureRect.left - padding, v0 = g.textureRect.top - padding;
+                float u1 = g.textureRect.left + g.textureRect.width + padding, v1 = g.textureRect.top + g.textureRect.height + padding;
+                verts.push_back(sf::Vertex(sf::Vector2f(l, t), color, sf::Vector2f(u0, v0)));
+                verts.push_back(sf::Vertex(sf::Vector2f(r, t), color, sf::Vector2f(u1, v0)));
+                verts.push_back(sf::Vertex(sf::Vector2f(l, b), color, sf::Vector2f(u0, v1)));
+                verts.push_back(sf::Vertex(sf::Vector2f(l, b), color, sf::Vector2f(u0, v1)));
+                verts.push_back(sf::Vertex(sf::Vector2f(r, t), color, sf::Vector2f(u1, v0)));
+                verts.push_back(sf::Vertex(sf::Vector2f(r, b), color, sf::Vector2f(u1, v1)));
+            }
+            penX += g.advance;
+        }
+        width = std::max(width, penX - x);
+    }
+
+    void offset(float dx, float dy) {
+        for (sf::Vertex& v : verts) v.position += sf::Vector2f(dx, dy);
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        if (font && !verts.empty()) target.draw(verts.data(), verts.size(), sf::Triangles, &font->getTexture(charSize));
+    }
+};
+
+// ---------------------------- Game State ------------------------------
+enum class Screen { Menu, Playing, GameOver, LevelComplete, Exit, GameCompleted, DailyResult };
+
+// Per-level memory: every container in a Level draws from one monotonic arena
+// that a rebuild rewinds in O(1). Allocations that miss the block spill to the
+// heap and are counted; the next rewind regrows the block to the high-water
+// mark, so once the largest level has been built, rebuilding a Level's data
+// does no general-purpose heap allocation. The rest of a transition (minimap
+// bake, background layout) refills member buffers that keep their capacity;
+// those settle once every level has been seen.
+static const size_t LEVEL_ARENA_INITIAL_BYTES = 64 * 1024;
+
+struct LevelArena : std::pmr::memory_resource {
+    std::unique_ptr<std::byte[]> block;
+    size_t capacity = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> bump;
+
+    size_t used = 0;      // bytes handed out since the last rewind, with alignment
+    size_t highWater = 0; // largest 'used' seen at a rewind
+    int rewinds = 0, regrows = 0;
+    int spills = 0;       // allocations since the last rewind that did not fit the block
+
+    explicit LevelArena(size_t bytes) { regrow(bytes); }
+    LevelArena(const LevelArena&) = delete;
+    LevelArena& operator=(const LevelArena&) = delete;
+
+    void regrow(size_t bytes) {
+        MemTagScope tag(MemLevel);
+        bump.reset();
+        block.reset(new std::byte[bytes]);
+        capacity = bytes;
+        bump.emplace(block.get(), capacity, std::pmr::new_delete_resource());
+        regrows++;
+    }
+
+    // Containers using the arena must have dropped their storage first
+    void rewind() {
+        highWater = std::max(highWater, used);
+        if (used > capacity) regrow(used + used / 4); // headroom for per-allocation padding
+        else bump->release();
+        used = 0;
+        spills = 0;
+        rewinds++;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t align) override {
+        used = (used + align - 1) / align * align + bytes;
+        if (used > capacity) spills++;
+        return bump->allocate(bytes, align);
+    }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+struct Level {
+    LevelArena arena{ LEVEL_ARENA_INITIAL_BYTES }; // declared first: outlives the containers below
+
+    int index = 0; // 0..4
+    sf::Uint32 seed = 0; // generated levels: the seed their ground came from
+    float length_m = 100.0f;
+    float length_px = 800.0f;
+    float finishX_px = 800.0f;
+
+    std::pmr::vector<FuelCan> cans{ &arena };
+    std::pmr::vector<Coin> coins{ &arena };
+
+    Heightfield field{ &arena };    // generated ground; empty for the five designed levels
+    TerrainCache terrain{ &arena }; // tessellated surface chunks, built lazily per LOD tier
+
+    Level() { terrain.field = &field; }
+    Level(const Level&) = delete;
+    Level& operator=(const Level&) = delete;
+
+    // Forgets all per-level storage and rewinds the arena
+    void clear() {
+        std::pmr::vector<FuelCan>(&arena).swap(cans);
+        std::pmr::vector<Coin>(&arena).swap(coins);
+        std::pmr::vector<float>(&arena).swap(field.y);
+        seed = 0;
+        terrain.release();
+        arena.rewind();
+    }
+};
+
+// Ground under x on this level: its heightfield if it has one, else the sine-sum
+GroundSample sampleGround(float x_px, const Level& level) {
+    if (level.field.empty()) return sampleGround(x_px, level.index);
+    return { level.field.height(x_px), level.field.slope(x_px) };
+}
+
+// Level data baked offline: per designed level, fuel can positions chosen from
+// measured fuel cost (--bake-levels) and coins placed on the envelope of
+// simulated runs (--bake-coins). Both were measured under one tuning, whose
+// hash the file records; under any other tuning the fixed layout is used.
+// Read once at startup (it is never written while levels build); levels copy
+// from it, so baked placement costs nothing at runtime.
+static const char* LEVEL_BAKE_FILE = "levels.bake";
+
+struct LevelBake {
+    struct BakedCoin { float x_m, hover_m; };
+    sf::Uint32 tuning = 0;        // tuningHash when baked; 0 if unknown
+    std::vector<float> cans_m[5]; // ascending, per designed level
+    std::vector<BakedCoin> coins[5];
+
+    // True while the game runs the tuning this was baked under
+    bool fitsTuning() const { return tuning != 0 && tuning == tuningHash(g_tuning); }
+
+    const std::vector<float>* cansFor(const Level& level) const {
+        if (!level.field.empty() || level.index < 0 || level.index >= 5) return nullptr;
+        if (!fitsTuning() || cans_m[level.index].empty()) return nullptr;
+        return &cans_m[level.index];
+    }
+
+    const std::vector<BakedCoin>* coinsFor(const Level& level) const {
+        if (!level.field.empty() || level.index < 0 || level.index >= 5) return nullptr;
+        if (!fitsTuning() || coins[level.index].empty()) return nullptr;
+        return &coins[level.index];
+    }
+};
+static LevelBake g_levelBake;
+
+// "tuning = <hex>", "level <n> cans = <x> ..." and "level <n> coins = <x>
+// <hover> ..." lines (m); '#' comments, other keys are skipped
+bool readLevelBake(const std::string& path, LevelBake& out) {
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) return false;
+    out = LevelBake{};
+    std::vector<char> line(1 << 16); // a can every metre of the longest level still fits
+    while (std::fgets(line.data(), static_cast<int>(line.size()), file)) {
+        if (char* hash = std::strchr(line.data(), '#')) *hash = '\0';
+        int number = 0, used = 0;
+        float value = 0.0f;
+        unsigned int tuning = 0;
+        if (std::sscanf(line.data(), " tuning = %x", &tuning) == 1) {
+            out.tuning = tuning;
+        }
+        else if (std::sscanf(line.data(), " level %d cans =%n", &number, &used) == 1 && used > 0 && number >= 1 && number <= 5) {
+            std::vector<float>& cans = out.cans_m[number - 1];
+            char* at = line.data() + used;
+            for (char* end = at; (value = std::strtof(at, &end)), end != at; at = end) cans.push_back(value);
+            std::sort(cans.begin(), cans.end());
+        }
+        else if (std::sscanf(line.data(), " level %d coins =%n", &number, &used) == 1 && used > 0 && number >= 1 && number <= 5) {
+            char* at = line.data() + used;
+            for (;;) {
+                char* end = at;
+                float x = std::strtof(at, &end);
+                if (end == at) break;
+                float hover = std::strtof(end, &at);
+                if (at == end) break;
+                out.coins[number - 1].push_back({ x, hover });
+            }
+        }
+    }
+    std::fclose(file);
+    return true;
+}
+
+bool writeLevelBake(const std::string& path, const LevelBake& bake) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "# Black And White Racing baked level data (--bake-levels); positions in metres\n");
+    std::fprintf(file, "tuning = %08x\n", static_cast<unsigned int>(bake.tuning));
+    for (int i = 0; i < 5; i++) {
+        if (bake.cans_m[i].empty()) continue;
+        std::fprintf(file, "level %d cans =", i + 1);
+        for (float x : bake.cans_m[i]) std::fprintf(file, " %.1f", x);
+        std::fprintf(file, "\n");
+    }
+    for (int i = 0; i < 5; i++) {
+        if (bake.coins[i].empty()) continue;
+        std::fprintf(file, "level %d coins =", i + 1);
+        for (const LevelBake::BakedCoin& c : bake.coins[i]) std::fprintf(file, " %.1f %.2f", c.x_m, c.hover_m);
+        std::fprintf(file, "\n");
+    }
+    std::fclose(file);
+    return true;
+}
+
+// Fuel cans at their baked positions, or else every fuelCanGapMeters from
+// 20 m; cans before takenBefore_px start taken (a live re-layout must not
+// refill the tank behind the car)
+void placeFuelCans(Level& level, float takenBefore_px) {
+    level.cans.clear();
+    if (const std::vector<float>* baked = g_levelBake.cansFor(level)) {
+        level.cans.reserve(baked->size());
+        for (float x_m : *baked) level.cans.push_back({ m2px(x_m), m2px(x_m) < takenBefore_px });
+        return;
+    }
+    float gap_px = m2px(std::max(1.0f, g_tuning.fuelCanGapMeters));
+    level.cans.reserve(static_cast<size_t>(std::ceil((level.finishX_px - m2px(20.0f)) / gap_px)) + 1);
+    for (float x = m2px(20.0f); x < level.finishX_px; x += gap_px) {
+        level.cans.push_back({ x, x < takenBefore_px });
+    }
+}
+
+// Coins hover a fixed height above the ground under them
+void settleCoins(Level& level) {
+    for (Coin& c : level.coins) c.y_px = sampleGround(c.x_px, level).y - c.hover_px;
+}
+
+// Coins baked on the run envelope, or else 20 coins evenly apart hovering a
+// bit above ground; coins before takenBefore_px start taken
+void placeCoins(Level& level, float takenBefore_px) {
+    level.coins.clear();
+    if (const std::vector<LevelBake::BakedCoin>* baked = g_levelBake.coinsFor(level)) {
+        level.coins.reserve(baked->size());
+        for (const LevelBake::BakedCoin& c : *baked)
+            level.coins.push_back({ m2px(c.x_m), 0.0f, m2px(c.x_m) < takenBefore_px, m2px(c.hover_m) });
+    }
+    else {
+        level.coins.reserve(COINS_PER_LEVEL);
+        float coinGap_px = level.length_px / (COINS_PER_LEVEL + 1);
+        for (int i = 1; i <= COINS_PER_LEVEL; i++)
+            level.coins.push_back({ i * coinGap_px, 0.0f, i * coinGap_px < takenBefore_px });
+    }
+    settleCoins(level);
+}
+
+// Fuel cans and coins for a level whose ground is in place
+void placePickups(Level& level) {
+    placeFuelCans(level, -1.0f);
+    placeCoins(level, -1.0f);
+}
+
+// Level layout (length, terrain cache, pickups); touches no game or GPU state
+void buildLevelData(Level& level, int idx) {
+    MemTagScope tag(MemLevel);
+    level.clear();
+    level.index = idx;
+    level.length_m = static_cast<float>(LEVEL_METERS[idx]);
+    level.length_px = m2px(level.length_m);
+    level.finishX_px = level.length_px;
+    level.terrain.reset(idx, level.finishX_px + 400.0f); // terrain is drawn up to 200 px past the finish
+
+    placePickups(level);
+}
+
+// Minimap: the whole level profile is rasterized once per level into a small render
+// texture. Each frame costs two draw calls: the baked texture, and one
+// vertex array holding the car and the remaining fuel can markers.
+static const unsigned MINIMAP_W = 360;
+static const unsigned MINIMAP_H = 48;
+static const float MINIMAP_X = (WINDOW_W - MINIMAP_W) * 0.5f;
+static const float MINIMAP_Y = 14.0f;
+
+struct Minimap {
+    sf::RenderTexture target;
+    bool created = false, ready = false;
+    float xScale = 1.0f, yScale = 1.0f, worldTop = 0.0f; // world -> minimap mapping
+    std::vector<sf::Vertex> markers;
+
+    // Bake geometry, set up with the target and refilled in place by every
+    // bake, so a level transition allocates nothing here
+    sf::VertexArray profile{ sf::TriangleStrip, (MINIMAP_W + 1) * 2 };
+    sf::RectangleShape finish, frame;
+
+    sf::Vector2f toMap(float x_px, float y_px) const {
+        return sf::Vector2f(MINIMAP_X + x_px * xScale, MINIMAP_Y + (y_px - worldTop) * yScale);
+    }
+
+    void bake(const Level& level) {
+        MemTagScope tag(MemRender);
+        if (!created) {
+            created = true;
+            ready = target.create(MINIMAP_W, MINIMAP_H);
+            finish.setSize(sf::Vector2f(2.0f, static_cast<float>(MINIMAP_H)));
+            finish.setPosition(MINIMAP_W - 2.0f, 0.0f);
+            finish.setFillColor(sf::Color(0, 120, 255));
+            frame.setSize(sf::Vector2f(MINIMAP_W - 2.0f, MINIMAP_H - 2.0f));
+            frame.setPosition(1.0f, 1.0f);
+            frame.setFillColor(sf::Color::Transparent);
+            frame.setOutlineColor(sf::Color::Black);
+            frame.setOutlineThickness(1.0f);
+        }
+        if (!ready) return;
+
+        // Sample the ground once per minimap column
+        float extent = level.finishX_px;
+        float heights[MINIMAP_W + 1];
+        float yMin = 1e9f, yMax = -1e9f;
+        for (unsigned col = 0; col <= MINIMAP_W; col++) {
+            heights[col] = sampleGround(extent * col / MINIMAP_W, level).y;
+            yMin = std::min(yMin, heights[col]);
+            yMax = std::max(yMax, heights[col]);
+        }
+        xScale = MINIMAP_W / extent;
+        worldTop = yMin - 40.0f;
+        yScale = MINIMAP_H / (yMax + 10.0f - worldTop);
+
+        for (unsigned col = 0; col <= MINIMAP_W; col++) {
+            float x = static_cast<float>(col);
+            profile[col * 2] = sf::Vertex(sf::Vector2f(x, (heights[col] - worldTop) * yScale), sf::Color(40, 40, 40));
+            profile[col * 2 + 1] = sf::Vertex(sf::Vector2f(x, static_cast<float>(MINIMAP_H)), sf::Color(40, 40, 40));
+        }
+
+        target.clear(sf::Color(255, 255, 255, 200));
+        target.draw(profile);
+        target.draw(finish);
+        target.draw(frame);
+        target.display();
+    }
+
+    void draw(sf::RenderTarget& win, const Level& level, const Vehicle& car) {
+        if (!ready) return;
+        sf::Sprite sprite(target.getTexture());
+        sprite.setPosition(MINIMAP_X, MINIMAP_Y);
+        win.draw(sprite);
+
+        markers.clear();
+        auto quad = [&](sf::Vector2f c, float hw, float hh, sf::Color col) {
+            sf::Vector2f a(c.x - hw, c.y - hh), b(c.x + hw, c.y - hh), d(c.x + hw, c.y + hh), e(c.x - hw, c.y + hh);
+            markers.push_back(sf::Vertex(a, col)); markers.push_back(sf::Vertex(b, col)); markers.push_back(sf::Vertex(d, col));
+            markers.push_back(sf::Vertex(a, col)); markers.push_back(sf::Vertex(d, col)); markers.push_back(sf::Vertex(e, col));
+        };
+        for (const auto& c : level.cans)
+            if (!c.taken) quad(toMap(c.x_px, sampleGround(c.x_px, level).y - 18.0f), 1.5f, 2.5f, sf::Color::Red);
+        sf::Vector2f carPos = toMap(clampf(car.x_px, 0.0f, level.finishX_px), car.y_px);
+        carPos.y = clampf(carPos.y, MINIMAP_Y + 3.0f, MINIMAP_Y + MINIMAP_H - 3.0f);
+        quad(carPos, 3.0f, 3.0f, sf::Color::Black);
+        win.draw(markers.data(), markers.size(), sf::Triangles);
+    }
+};
+
+// Level prefetch: while a result screen is up, the levels the player is likely
+// to pick next are built on a worker thread (layout, pickups, every terrain
+// tessellation tier, background sprites). buildLevel() then swaps a ready
+// Level in instead of building it after the click.
+static const int PREFETCH_SLOTS = 2;
+
+struct PreparedLevel {
+    std::unique_ptr<Level> level = std::make_unique<Level>(); // Levels own their arena and are never moved
+    ParallaxLayer layers[Background::LAYERS];
+};
+
+void prepareLevel(PreparedLevel& out, int idx) {
+    buildLevelData(*out.level, idx);
+    out.level->terrain.buildAll();
+    Background::layoutLevel(idx, out.layers);
+}
+
+// The daily challenge level, built by prepareDaily (see Daily challenge)
+struct DailyLevel {
+    int date = 0;           // UTC yyyymmdd; 0 until generated
+    sf::Uint32 seed = 0, hash = 0;
+    bool verified = false;  // this build reproduces the reference level's hash
+    PreparedLevel prepared; // holds the designed level instead while the daily is played
+};
+
+struct LevelPrefetcher {
+    enum class SlotState { Empty, Queued, Building, Ready };
+    struct Slot {
+        int index = -1;
+        SlotState state = SlotState::Empty;
+        sf::Uint32 stamp = 0; // request order, oldest is evicted first
+        PreparedLevel data;
+    };
+    Slot slots[PREFETCH_SLOTS];
+    sf::Uint32 nextStamp = 1;
+    std::mutex mutex;
+    std::condition_variable wake, built;
+    std::thread worker;
+    bool stopping = false;
+
+    ~LevelPrefetcher() { stop(); }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    // Queues a background build of level idx unless it is already queued or ready
+    void request(int idx) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot* victim = nullptr;
+            for (Slot& s : slots) {
+                if (s.index == idx && s.state != SlotState::Empty) {
+                    s.stamp = nextStamp++;
+                    return;
+                }
+                if (s.state == SlotState::Building) continue;
+                if (!victim || s.state == SlotState::Empty ||
+                    (victim->state != SlotState::Empty && s.stamp < victim->stamp)) victim = &s;
+            }
+            if (!victim) return;
+            victim->index = idx;
+            victim->state = SlotState::Queued;
+            victim->stamp = nextStamp++;
+            if (!worker.joinable()) worker = std::thread(&LevelPrefetcher::run, this);
+        }
+        wake.notify_one();
+    }
+
+    // Hands over a level built elsewhere (startup builds level 1 this way)
+    void adopt(int idx, PreparedLevel& built) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot* target = nullptr;
+        for (Slot& s : slots) {
+            if (s.state == SlotState::Building) continue;
+            if (!target || s.index == idx || (target->index != idx && s.stamp < target->stamp)) target = &s;
+        }
+        if (!target) return;
+        std::swap(target->data.level, built.level);
+        for (int i = 0; i < Background::LAYERS; i++) std::swap(target->data.layers[i], built.layers[i]);
+        target->index = idx;
+        target->state = SlotState::Ready;
+        target->stamp = nextStamp++;
+    }
+
+    // True when no build is queued or running, i.e. nothing reads the tuning
+    bool idle() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Slot& s : slots)
+            if (s.state == SlotState::Queued || s.state == SlotState::Building) return false;
+        return true;
+    }
+
+    // Drops prepared levels (built with an older tuning); buffers are kept
+    void invalidate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Slot& s : slots)
+            if (s.state != SlotState::Building) s.state = SlotState::Empty;
+    }
+
+    // Swaps a prefetched level into place. Waits if it is mid-build; returns
+    // false when idx was never requested or not yet started.
+    bool take(int idx, std::unique_ptr<Level>& level, ParallaxLayer (&layers)[Background::LAYERS]) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (Slot& s : slots) {
+            if (s.index != idx || s.state == SlotState::Empty) continue;
+            if (s.state == SlotState::Queued) {
+                s.state = SlotState::Empty; // building inline is no slower
+                return false;
+            }
+            built.wait(lock, [&] { return s.state == SlotState::Ready; });
+            std::swap(level, s.data.level);
+            for (int i = 0; i < Background::LAYERS; i++) std::swap(layers[i], s.data.layers[i]);
+            s.state = SlotState::Empty; // keeps the old level's buffers for reuse
+            return true;
+        }
+        return false;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            Slot* job = nullptr;
+            wake.wait(lock, [&] {
+                if (stopping) return true;
+                for (Slot& s : slots)
+                    if (s.state == SlotState::Queued && (!job || s.stamp < job->stamp)) job = &s;
+                return job != nullptr;
+            });
+            if (stopping) return;
+
+            job->state = SlotState::Building;
+            int idx = job->index;
+            lock.unlock();
+            prepareLevel(job->data, idx);
+            lock.lock();
+            job->state = SlotState::Ready;
+            built.notify_all();
+        }
+    }
+};
+
+// Retained drawables for the playing screen; frames only move and resize them
+struct VehicleShapes {
+    sf::CircleShape wheel, head;
+    sf::RectangleShape body, torso;
+
+    explicit VehicleShapes(const Vehicle& V) {
+        wheel.setRadius(V.wheelR);
+        wheel.setOrigin(V.wheelR, V.wheelR);
+        wheel.setFillColor(sf::Color(30, 30, 30));
+
+        body.setSize(sf::Vector2f(V.bodyW, V.bodyH));
+        body.setOrigin(V.bodyW * 0.5f, V.bodyH * 0.5f);
+        body.setFillColor(sf::Color::Black);
+
+        torso.setSize(sf::Vector2f(V.bodyH * 0.6f, V.bodyH * 0.8f));
+        torso.setOrigin(torso.getSize().x * 0.5f, torso.getSize().y);
+        torso.setFillColor(sf::Color(60, 60, 60));
+
+        float headR = V.bodyH * 0.28f;
+        head.setRadius(headR);
+        head.setOrigin(headR, headR);
+        head.setFillColor(sf::Color(80, 80, 80));
+    }
+};
+
+struct Hud {
+    static constexpr float FUEL_BAR_W = 280.0f, FUEL_BAR_H = 18.0f;
+    sf::RectangleShape fuelOutline, fuelFill;
+    TextBatch text;
+
+    Hud() {
+        fuelOutline.setSize(sf::Vector2f(FUEL_BAR_W, FUEL_BAR_H));
+        fuelOutline.setPosition(20.0f, 20.0f);
+        fuelOutline.setFillColor(sf::Color::Transparent);
+        fuelOutline.setOutlineColor(sf::Color::Black);
+        fuelOutline.setOutlineThickness(2.0f);
+        fuelFill.setPosition(20.0f, 20.0f);
+        fuelFill.setFillColor(sf::Color::Black);
+    }
+};
+
+// One attempt at a level: the car and everything the rules track while it
+// drives. The game plays one at a time; the level validator's bots copy and
+// branch them, so it holds no resources.
+struct RunState {
+    Vehicle car;
+
+    // Progress
+    float fuel_m = g_tuning.fuelTankMeters; // remaining meters worth of fuel
+    float lastX_forFuel_px = 0.0f;   // to deduct fuel by horizontal travel
+
+    int coinsCollected = 0;
+    float levelDistance_m = 0.0f; // current level distance traveled
+
+    bool headHitGround = false;
+    float fuel_out_timer = -1.0f;
+
+    // Full tank, car at rest on the start line
+    void startRun(const Level& level) {
+        fuel_m = g_tuning.fuelTankMeters;
+        lastX_forFuel_px = 0.0f;
+        levelDistance_m = 0.0f;
+        coinsCollected = 0;
+        headHitGround = false;
+        fuel_out_timer = -1.0f;
+
+        // Place vehicle at start
+        auto g0 = sampleGround(0.0f, level);
+        car.reset(10.0f, g0.y);
+
+        // Explicitly reset vehicle speed and other relevant variables
+        car.vx = 0.0f;
+        car.vy = 0.0f;
+        car.pressingLeft = false;
+        car.pressingRight = false;
+    }
+};
+
+struct Game : RunState {
+    Screen screen = Screen::Menu;
+    sf::Font font; bool hasFont = false;
+
+    // Terrain render mode: GPU shader when available and verified, CPU strip otherwise
+    TerrainShader terrainShader;
+    bool useTerrainShader = false;
+
+    Camera camera;
+    int lodTier = 0; // LOD tier of the current view (see terrainLodTier)
+
+    ParticlePool particles{ PARTICLE_CAPACITY };
+    Background background;
+    FramePacer pacer;
+    DynamicResolution resolution;
+    FrameCapture capture;
+    LevelThumbnails thumbnails;
+    Minimap minimap;
+    LevelPrefetcher prefetcher;
+
+    // Timestamped driving input and the per-level log of applied transitions
+    InputSampler input;
+    sf::Uint32 tick = 0; // physics steps since the level started
+    std::vector<InputRecord> inputLog; // capacity fixed in reserveFrameBuffers
+    bool inputLogFull = false;         // transitions after it filled were not recorded
+    LatencyProbe latency;
+
+    // CPU terrain strip and pickup batch, reused every frame
+    std::vector<sf::Vertex> terrainVerts;
+    std::vector<sf::Vertex> pickupVerts;
+    Hud hud;
+    TextBatch statsText;
+
+    // Debug overlay (F3)
+    bool showStats = false;
+    int statTerrainVertices = 0;
+    int statTerrainTier = 0;
+    float statTerrainError_px = 0.0f;
+    float statLevelBuild_ms = 0.0f; // last buildLevel(), prefetched or not
+    bool statLevelPrefetched = false;
+    size_t statRss_bytes = 0; // sampled every RSS_SAMPLE_FRAMES frames while the overlay is on
+    int statFrames = 0;
+
+    int unlockedLevels = 1; // must beat previous to unlock next
+    int currentLevel = 0;
+
+    VehicleShapes vehicleShapes{ car };
+    std::unique_ptr<Level> level = std::make_unique<Level>();
+
+    // Daily challenge: generated during startup, swapped in for play
+    DailyLevel daily;
+    bool playingDaily = false;
+    bool dailyFinished = false; // last daily run reached the finish
+
+    // Totals across all finished levels
+    float totalDistance_m = 0.0f;
+    int   totalCoins = 0;
+
+    // Retained menu screens
+    UiScreen menuUi, gameOverUi, levelCompleteUi, gameCompletedUi, dailyResultUi;
+
+    void setupFont() {
+        bool loaded = loadFont();
+        if (loaded) prewarmGlyphs();
+        setupUi(loaded);
+    }
+
+    // Disk load only; safe on a worker thread as long as nothing draws text yet
+    bool loadFont() {
+        MemTagScope tag(MemFont);
+        return font.loadFromFile("C:/Windows/Fonts/arial.ttf");
+    }
+
+    // Rasterizes every glyph the UI, HUD and overlay use, so no frame does.
+    // Needs a GL context; worker threads create their own.
+    void prewarmGlyphs() {
+        MemTagScope tag(MemFont);
+        static const unsigned sizes[] = { 16, 18, 22, 24, 28, 42, 48 };
+        for (unsigned size : sizes)
+            for (sf::Uint32 ch = 32; ch < 127; ch++) font.getGlyph(ch, size, false);
+        font.getGlyph(GLYPH_LEFT_ARROW, 60, false);
+        font.getGlyph(GLYPH_RIGHT_ARROW, 60, false);
+    }
+
+    // Main thread: text batches and menu widgets (HUD will be minimal but playable without a font)
+    void setupUi(bool fontLoaded) {
+        hasFont = fontLoaded;
+        if (hasFont) {
+            hud.text.setup(font, 18, sf::Color::Black, 128);
+            statsText.setup(font, 16, sf::Color::Black, 2048);
+        }
+
+        // Result screens are only interactive with a font, as before
+        if (hasFont) {
+            menuUi.build(MENU_LAYOUT, std::size(MENU_LAYOUT), &font);
+            gameOverUi.build(GAME_OVER_LAYOUT, std::size(GAME_OVER_LAYOUT), &font);
+            levelCompleteUi.build(LEVEL_COMPLETE_LAYOUT, std::size(LEVEL_COMPLETE_LAYOUT), &font);
+            gameCompletedUi.build(GAME_COMPLETED_LAYOUT, std::size(GAME_COMPLETED_LAYOUT), &font);
+            dailyResultUi.build(DAILY_RESULT_LAYOUT, std::size(DAILY_RESULT_LAYOUT), &font);
+        }
+        else {
+            menuUi.build(MENU_FALLBACK_LAYOUT, std::size(MENU_FALLBACK_LAYOUT), nullptr);
+        }
+    }
+
+    // Sizes every per-frame buffer for its worst case so playing never grows one
+    void reserveFrameBuffers() {
+        {
+            MemTagScope tag(MemInputLog);
+            inputLog.reserve(INPUT_LOG_CAPACITY);
+        }
+        MemTagScope tag(MemRender);
+        terrainVerts.reserve(16384);
+        pickupVerts.reserve(4096);
+        background.verts.reserve(4096);
+        minimap.markers.reserve(1024);
+    }
+
+    // The shader evaluates the designed sine-sum only; generated ground uses the CPU strip
+    bool shaderTerrain() const { return useTerrainShader && level->field.empty(); }
+
+    UiScreen* uiFor(Screen s) {
+        switch (s) {
+        case Screen::Menu: return &menuUi;
+        case Screen::GameOver: return &gameOverUi;
+        case Screen::LevelComplete: return &levelCompleteUi;
+        case Screen::GameCompleted: return &gameCompletedUi;
+        case Screen::DailyResult: return &dailyResultUi;
+        default: return nullptr;
+        }
+    }
+
+    void buildLevel(int idx) {
+        sf::Clock buildTimer;
+        leaveDaily();
+        currentLevel = idx;
+        statLevelPrefetched = prefetcher.take(idx, level, background.layers);
+        if (!statLevelPrefetched) {
+            buildLevelData(*level, idx);
+            background.buildLevel(idx);
+        }
+        beginRun(buildTimer);
+    }
+
+    // Plays the daily level: swapped in with its background the first time,
+    // then only its pickups are reset (cans follow the current tuning)
+    void startDaily() {
+        sf::Clock buildTimer;
+        if (!playingDaily) {
+            std::swap(level, daily.prepared.level);
+            for (int i = 0; i < Background::LAYERS; i++) std::swap(background.layers[i], daily.prepared.layers[i]);
+            playingDaily = true;
+        }
+        placeFuelCans(*level, -1.0f);
+        for (Coin& c : level->coins) c.taken = false;
+        statLevelPrefetched = true;
+        beginRun(buildTimer);
+    }
+
+    // Swaps the daily back out, so designed levels never build over it
+    void leaveDaily() {
+        if (!playingDaily) return;
+        std::swap(level, daily.prepared.level);
+        for (int i = 0; i < Background::LAYERS; i++) std::swap(background.layers[i], daily.prepared.layers[i]);
+        playingDaily = false;
+    }
+
+    // Common tail of a level start, once *level is in place
+    void beginRun(const sf::Clock& buildTimer) {
+        minimap.bake(*level);
+
+        startRun(*level);
+        camera.snap(car);
+        tick = 0;
+        inputLog.clear();
+        inputLogFull = false;
+        particles.clear();
+        statLevelBuild_ms = buildTimer.getElapsedTime().asMicroseconds() / 1000.0f;
+    }
+
+    // Starts building the levels a result screen is likely to lead to
+    void prefetchLikelyLevels() {
+        int next = std::min(currentLevel + 1, 4);
+        if (screen == Screen::LevelComplete && next < unlockedLevels) prefetcher.request(next);
+        prefetcher.request(currentLevel);
+    }
+
+    void resetGame() {
+        unlockedLevels = 1;
+        currentLevel = 0;
+        totalDistance_m = 0.0f;
+        totalCoins = 0;
+        coinsCollected = 0;
+        fuel_m = g_tuning.fuelTankMeters;
+        lastX_forFuel_px = 0.0f;
+        levelDistance_m = 0.0f;
+        headHitGround = false;
+        fuel_out_timer = -1.0f;
+        car.pressingLeft = false;
+        car.pressingRight = false;
+        buildLevel(0);
+    }
+};
+
+// ---------------------------- Physics ---------------------------------
+void stepVehicle(RunState& R, const Level& level, float dt) {
+    Vehicle& V = R.car;
+
+    // Simple gravity
+    V.vy += g_tuning.gravity * dt;
+
+    // Tentative position without input acceleration
+    float tempX = V.x_px + V.vx * dt;
+    float tempY = V.y_px + V.vy * dt;
+    float tempAngle = V.angle + V.angV * dt;
+
+    // Tentative wheel positions
+    sf::Vector2f tempFront = V.localToWorldTemp(tempX, tempY, tempAngle, +V.wheelBase * 0.5f, V.bodyH * 0.5f);
+    sf::Vector2f tempRear = V.localToWorldTemp(tempX, tempY, tempAngle, -V.wheelBase * 0.5f, V.bodyH * 0.5f);
+
+    // Check if would be on ground
+    bool onGroundTentative = false;
+    auto checkContact = [&](sf::Vector2f wp) {
+        auto gs = sampleGround(wp.x, level);
+        float groundY = gs.y - V.wheelR;
+        float dy = wp.y - groundY;
+        if (dy > 0.0f) {
+            onGroundTentative = true;
+        }
+        };
+    checkContact(tempFront);
+    checkContact(tempRear);
+
+    // Input forces only if fuel > 0
+    if (R.fuel_m > 0.0f) {
+        const float accel = g_tuning.accel;
+        const float torque = g_tuning.torque;
+
+        if (V.pressingRight) {
+            if (onGroundTentative) {
+                float dirX = std::cos(tempAngle);
+                float dirY = std::sin(tempAngle);
+                V.vx += accel * dt * dirX;
+                V.vy += accel * dt * dirY;
+            }
+            V.angV -= torque * dt; // clockwise (front flip)
+        }
+        if (V.pressingLeft) {
+            if (onGroundTentative) {
+                float dirX = std::cos(tempAngle);
+                float dirY = std::sin(tempAngle);
+                V.vx -= accel * dt * dirX;
+                V.vy -= accel * dt * dirY;
+            }
+            V.angV += torque * dt; // anti-clockwise (back flip)
+        }
+    }
+
+    // Integrate position with updated velocities
+    V.x_px += V.vx * dt;
+    V.y_px += V.vy * dt;
+    V.angle += V.angV * dt;
+
+    // Wheel-ground collision & alignment
+    int wheelsOnGround = 0;
+    auto fixWheel = [&](sf::Vector2f wp) {
+        auto gs = sampleGround(wp.x, level);
+        float groundY = gs.y - V.wheelR;
+        float dy = wp.y - groundY;
+        if (dy > 0.0f) { // wheel penetrates ground -> push car up
+            wheelsOnGround++;
+            // Move chassis up by dy projected along body-down direction (approx)
+            V.y_px -= dy;
+            V.vy = std::min(0.0f, V.vy);
+            // Dampen angular velocity and align angle slightly with slope
+            float targetAngle = std::atan(gs.slope);
+            float alignRate = g_tuning.slopeAlignRate * dt;
+            // wrap to nearest
+            float da = targetAngle - V.angle;
+            while (da > 3.14159f) da -= 6.28318f;
+            while (da < -3.14159f) da += 6.28318f;
+            V.angle += clampf(da, -alignRate, alignRate);
+        }
+        };
+
+    fixWheel(V.frontWheelPos());
+    fixWheel(V.rearWheelPos());
+
+    V.wheelsOnGround = wheelsOnGround;
+    if (wheelsOnGround > 0) {
+        float groundFriction = (R.fuel_m > 0.0f ? g_tuning.groundFriction : g_tuning.groundFrictionNoFuel);
+        V.vx *= groundFriction;
+        V.angV *= g_tuning.groundAngularDamping;
+    }
+
+    // Air drag & angular damping
+    V.vx *= g_tuning.airDrag;
+    V.angV *= g_tuning.airAngularDamping;
+}
+
+// Deduct fuel based on horizontal distance traveled; refill on can pickup
+void updateFuelAndPickups(RunState& R, Level& level, ParticlePool* fx) {
+    float dx_px = std::fabs(R.car.x_px - R.lastX_forFuel_px);
+    if (dx_px > 0.0f) {
+        float consumed_m = px2m(dx_px);
+        R.fuel_m = std::max(0.0f, R.fuel_m - consumed_m);
+        R.levelDistance_m += consumed_m;
+        R.lastX_forFuel_px = R.car.x_px;
+    }
+
+    sf::Vector2f fw = R.car.frontWheelPos();
+    sf::Vector2f rw = R.car.rearWheelPos();
+
+    // Fuel cans
+    for (auto& c : level.cans) {
+        if (!c.taken) {
+            auto gs = sampleGround(c.x_px, level);
+            float canY = gs.y - 18.0f;
+            float dx_c = c.x_px - R.car.x_px;
+            float dy_c = canY - R.car.y_px;
+            float dist_c = std::sqrt(dx_c * dx_c + dy_c * dy_c);
+            float dx_f = c.x_px - fw.x;
+            float dy_f = canY - fw.y;
+            float dist_f = std::sqrt(dx_f * dx_f + dy_f * dy_f);
+            float dx_r = c.x_px - rw.x;
+            float dy_r = canY - rw.y;
+            float dist_r = std::sqrt(dx_r * dx_r + dy_r * dy_r);
+            float min_dist = std::min({ dist_c, dist_f, dist_r });
+            if (min_dist < 30.0f) {
+                c.taken = true;
+                R.fuel_m = g_tuning.fuelTankMeters; // refill to full
+                if (fx) fx->burst(c.x_px, canY, 40, 160.0f, 0.8f, 4.0f, sf::Color(220, 30, 30));
+            }
+        }
+    }
+
+    // Coins
+    for (auto& coin : level.coins) {
+        if (!coin.taken) {
+            float dx_c = coin.x_px - R.car.x_px;
+            float dy_c = coin.y_px - R.car.y_px;
+            float dist_c = std::sqrt(dx_c * dx_c + dy_c * dy_c);
+            float dx_f = coin.x_px - fw.x;
+            float dy_f = coin.y_px - fw.y;
+            float dist_f = std::sqrt(dx_f * dx_f + dy_f * dy_f);
+            float dx_r = coin.x_px - rw.x;
+            float dy_r = coin.y_px - rw.y;
+            float dist_r = std::sqrt(dx_r * dx_r + dy_r * dy_r);
+            float min_dist = std::min({ dist_c, dist_f, dist_r });
+            if (min_dist < 28.0f) {
+                coin.taken = true;
+                R.coinsCollected++;
+                if (fx) fx->burst(coin.x_px, coin.y_px, 24, 120.0f, 0.6f, 3.0f, sf::Color(30, 200, 30));
+            }
+        }
+    }
+}
+
+// Head-ground collision -> game over
+bool checkHeadHit(const RunState& R, const Level& level) {
+    auto hp = R.car.headPos();
+    auto gs = sampleGround(hp.x, level);
+    return (hp.y >= gs.y - 3.0f); // small tolerance
+}
+
+enum class RunOutcome { Running, Finished, Crashed, OutOfFuel };
+
+// One fixed step of the rules: drive, fuel and pickups, the head hit, the
+// fuel-out countdown and the finish line. fx receives pickup bursts (null
+// when headless). A crash or fuel-out on the finish step still ends the run.
+RunOutcome stepRun(RunState& R, Level& level, float dt, ParticlePool* fx) {
+    stepVehicle(R, level, dt);
+    updateFuelAndPickups(R, level, fx);
+
+    // Head-ground check
+    if (checkHeadHit(R, level)) {
+        R.headHitGround = true;
+    }
+
+    // Fuel check
+    if (R.fuel_m <= 0.0f) {
+        if (R.fuel_out_timer < 0.0f) {
+            R.fuel_out_timer = 5.0f;
+        }
+        else {
+            R.fuel_out_timer -= dt;
+        }
+    }
+    else {
+        R.fuel_out_timer = -1.0f;
+    }
+
+    if (R.headHitGround) return RunOutcome::Crashed;
+    if (R.fuel_out_timer <= 0.0f && R.fuel_out_timer > -1.0f) return RunOutcome::OutOfFuel;
+    if (R.car.x_px >= level.finishX_px) return RunOutcome::Finished;
+    return RunOutcome::Running;
+}
+
+// Records an applied transition; a full log says so once instead of growing mid-run
+void logInput(Game& G, sf::Uint8 control, bool pressed) {
+    if (G.inputLog.size() < G.inputLog.capacity()) {
+        G.inputLog.push_back({ G.tick, control, pressed });
+    }
+    else if (!G.inputLogFull) {
+        G.inputLogFull = true;
+        std::cout << "Input log: full at " << G.inputLog.size() << " transitions (tick " << G.tick
+                  << "); the rest of this run is not recorded" << std::endl;
+    }
+}
+
+// Applies queued input transitions that arrived before stepEnd_us, recording them
+void applyInputs(Game& G, sf::Int64 stepEnd_us) {
+    InputEvent e;
+    while (G.input.queue.peek(e) && e.time_us <= stepEnd_us) {
+        G.input.queue.pop();
+        G.latency.onConsumed(e.time_us);
+        if (e.control == InputLeft) G.car.pressingLeft = e.pressed;
+        else G.car.pressingRight = e.pressed;
+        logInput(G, e.control, e.pressed);
+    }
+}
+
+// Drops queued input while no level is being played
+void discardInputs(Game& G) {
+    InputEvent e;
+    while (G.input.queue.peek(e)) G.input.queue.pop();
+}
+
+// A run starts from the controls held right now: menus dropped their
+// transitions, so a key held through Retry or a level start would otherwise
+// not drive until pressed again. Seeded presses go in the input log at tick 0.
+void seedInputs(Game& G) {
+    discardInputs(G);
+    for (sf::Uint8 c = 0; c < InputControlCount; c++) {
+        bool pressed = G.input.held[c].load(std::memory_order_acquire);
+        if (c == InputLeft) G.car.pressingLeft = pressed;
+        else G.car.pressingRight = pressed;
+        if (pressed) logInput(G, c, true);
+    }
+}
+
+// Dust from wheels in ground contact and exhaust while throttling; called per physics step
+void emitVehicleEffects(Game& G, float dt) {
+    Vehicle& V = G.car;
+    ParticlePool& P = G.particles;
+    float speed = std::fabs(V.vx);
+
+    if (V.wheelsOnGround > 0 && speed > 40.0f) {
+        int n = P.budgeted(speed * 0.15f * dt * V.wheelsOnGround);
+        for (int i = 0; i < n; i++) {
+            sf::Vector2f w = (P.rng.next01() < 0.5f) ? V.rearWheelPos() : V.frontWheelPos();
+            P.spawn(w.x + P.rng.range(-6.0f, 6.0f), w.y + V.wheelR - 2.0f,
+                    -V.vx * P.rng.range(0.1f, 0.3f), -P.rng.range(20.0f, 70.0f),
+                    P.rng.range(0.4f, 0.9f), P.rng.range(3.0f, 6.0f), sf::Color(110, 100, 90, 180));
+        }
+    }
+
+    if (G.fuel_m > 0.0f && (V.pressingRight || V.pressingLeft)) {
+        int n = P.budgeted(40.0f * dt);
+        sf::Vector2f pipe = V.localToWorld(-V.bodyW * 0.5f, V.bodyH * 0.25f);
+        float c = std::cos(V.angle), s = std::sin(V.angle);
+        for (int i = 0; i < n; i++) {
+            float sp = P.rng.range(30.0f, 60.0f);
+            P.spawn(pipe.x, pipe.y, V.vx - c * sp, V.vy - s * sp - 15.0f,
+                    P.rng.range(0.3f, 0.6f), P.rng.range(2.0f, 4.0f), sf::Color(70, 70, 70, 150));
+        }
+    }
+}
+
+// ---------------------------- Rendering -------------------------------
+// World px covered by one target pixel under the target's current view
+float worldPerPixel(const sf::RenderTarget& target) {
+    const sf::View& view = target.getView();
+    return view.getSize().x / (static_cast<float>(target.getSize().x) * view.getViewport().width);
+}
+
+void drawTerrain(sf::RenderTarget& win, Game& G, float xStart, float xEnd) {
+    const sf::View& view = win.getView();
+    float pixelSize = worldPerPixel(win);
+    int tier = G.lodTier;
+    float bottom = std::max(static_cast<float>(WINDOW_H), view.getCenter().y + view.getSize().y * 0.5f);
+
+    // Stitch the cached chunks overlapping [xStart, xEnd] into one strip
+    std::vector<sf::Vertex>& verts = G.terrainVerts;
+    verts.clear();
+    float maxError = 0.0f;
+    int first = std::max(0, static_cast<int>(xStart / TERRAIN_CHUNK_PX));
+    int last = std::min(static_cast<int>(xEnd / TERRAIN_CHUNK_PX),
+                        static_cast<int>(G.level->terrain.tiers[tier].size()) - 1);
+    for (int i = first; i <= last; i++) {
+        const TerrainChunk& c = G.level->terrain.chunk(tier, i);
+        maxError = std::max(maxError, c.maxError_px);
+        for (size_t k = (verts.empty() ? 0 : 1); k < c.points.size(); k++) {
+            const sf::Vector2f& pt = c.points[k];
+            verts.push_back(sf::Vertex(pt, sf::Color::Black));
+            verts.push_back(sf::Vertex(sf::Vector2f(pt.x, bottom), sf::Color::Black));
+        }
+    }
+
+    G.statTerrainVertices = static_cast<int>(verts.size());
+    G.statTerrainTier = tier;
+    G.statTerrainError_px = maxError / pixelSize;
+    if (!verts.empty()) win.draw(verts.data(), verts.size(), sf::TriangleStrip);
+}
+
+// Draws the terrain as a single quad evaluated per pixel by the terrain shader
+void drawTerrainShader(sf::RenderTarget& win, Game& G, float xStart, float xEnd) {
+    const sf::View& view = win.getView();
+    float pixelSize = worldPerPixel(win);
+    float yTop = view.getCenter().y - view.getSize().y * 0.5f;
+    float yBottom = std::max(static_cast<float>(WINDOW_H), view.getCenter().y + view.getSize().y * 0.5f);
+
+    sf::Vertex quad[4];
+    TerrainShader::makeQuad(quad, xStart, xEnd, yTop, yBottom);
+    G.terrainShader.setParams(G.currentLevel, pixelSize);
+    win.draw(quad, 4, sf::TriangleStrip, &G.terrainShader.shader);
+}
+
+void drawVehicle(sf::RenderTarget& win, Game& G) {
+    const Vehicle& V = G.car;
+    VehicleShapes& S = G.vehicleShapes;
+    float angle_deg = V.angle * 180.0f / 3.1415926f;
+
     // Wheels
-    sf::CircleShape wheel(V.wheelR);
-    wheel.setOrigin(V.wheelR, V.wheelR);
-    wheel.setFillColor(sf::Color(30, 30, 30));
+    S.wheel.setPosition(V.frontWheelPos()); win.draw(S.wheel);
+    S.wheel.setPosition(V.rearWheelPos()); win.draw(S.wheel);
+
+    // Chassis (black)
+    S.body.setPosition(V.x_px, V.y_px);
+    S.body.setRotation(angle_deg);
+    win.draw(S.body);
+
+    // Man: simple seat + head; head follows rotation
+    S.torso.setPosition(V.localToWorld(-V.bodyW * 0.1f, -V.bodyH * 0.1f));
+    S.torso.setRotation(angle_deg);
+    win.draw(S.torso);
+
+    S.head.setPosition(V.headPos());
+    win.draw(S.head);
+}
+
+void drawHUD(sf::RenderWindow& win, Game& G) {
+    // Background is white; draw black HUD elements
+    // Fuel bar
+    Hud& H = G.hud;
+    win.draw(H.fuelOutline);
+    float pct = clampf(G.fuel_m / g_tuning.fuelTankMeters, 0.0f, 1.0f);
+    H.fuelFill.setSize(sf::Vector2f(Hud::FUEL_BAR_W * pct, Hud::FUEL_BAR_H));
+    win.draw(H.fuelFill);
+
+    if (G.hasFont) {
+        // Distance & coins
+        char buf[128];
+        if (G.playingDaily)
+            std::snprintf(buf, sizeof(buf), "Daily  Dist: %.1fm  Coins: %d", G.levelDistance_m, G.coinsCollected);
+        else
+            std::snprintf(buf, sizeof(buf), "Level %d  Dist: %.1fm  Coins: %d", G.currentLevel + 1, G.levelDistance_m, G.coinsCollected);
+        H.text.layout(buf, 20.0f, 46.0f);
+        H.text.draw(win);
+    }
+}
+
+// Parallax background in screen space: one textured draw call for all layers
+void drawBackground(sf::RenderTarget& win, Game& G, const sf::View& camera) {
+    if (!G.background.ready) return;
+    sf::View screen(sf::FloatRect(0.0f, 0.0f, static_cast<float>(WINDOW_W), static_cast<float>(WINDOW_H)));
+    screen.setViewport(camera.getViewport());
+    win.setView(screen);
+    G.background.build(camera.getCenter().x, camera.getCenter().y);
+    const std::vector<sf::Vertex>& verts = G.background.verts;
+    if (!verts.empty()) win.draw(verts.data(), verts.size(), sf::Triangles, &G.background.atlas);
+}
+
+// All particles in one draw call
+void drawParticles(sf::RenderTarget& win, const Game& G) {
+    const ParticlePool& P = G.particles;
+    if (P.vertCount > 0) win.draw(P.verts.data(), P.vertCount, sf::Triangles);
+}
+
+inline double memMB(long long bytes) { return bytes / (1024.0 * 1024.0); }
+static const int RSS_SAMPLE_FRAMES = 30;
+
+// Debug overlay (F3): renderer statistics for the last frame
+void drawStats(sf::RenderWindow& win, Game& G) {
+    if (!G.showStats || !G.hasFont) return;
+    if (G.statFrames++ % RSS_SAMPLE_FRAMES == 0) G.statRss_bytes = processRssBytes();
+
+    char buf[2048]; // well above the longest overlay, so appends never truncate
+    int len = 0;
+    if (G.shaderTerrain())
+        len = std::snprintf(buf, sizeof(buf), "Terrain: shader (max err %.2f px)", G.terrainShader.maxError_px);
+    else
+        len = std::snprintf(buf, sizeof(buf), "Terrain: %d verts  LOD %d  max err %.2f px",
+            G.statTerrainVertices, G.statTerrainTier, G.statTerrainError_px);
+    len += std::snprintf(buf + len, sizeof(buf) - len, "\nCamera: zoom %.2fx  LOD %d  pickup verts %d",
+        G.camera.zoom, G.lodTier, static_cast<int>(G.pickupVerts.size()));
+    FramePacer::Stats ps = G.pacer.stats();
+    len += std::snprintf(buf + len, sizeof(buf) - len, "\nPacing: %s  mean %.2f ms  sd %.2f  p99 %.2f  |err| %.3f ms",
+        G.pacer.mode == PacingMode::VSync ? "vsync" : "fixed 120 Hz",
+        ps.mean_ms, ps.stddev_ms, ps.p99_ms, ps.meanAbsError_ms);
+    len += std::snprintf(buf + len, sizeof(buf) - len, "\nResolution: %d%%  render %.2f ms / target %.2f ms",
+        static_cast<int>(G.resolution.scale * 100.0f + 0.5f), G.resolution.avg_ms, G.resolution.target_ms);
+    if (G.latency.enabled) {
+        len += std::snprintf(buf + len, sizeof(buf) - len, "\nLatency p50/p95/p99: %.1f / %.1f / %.1f ms  (q %.1f  sim %.1f  rnd %.1f  pres %.1f)",
+            G.latency.percentile(LatencyProbe::Total, 0.50f), G.latency.percentile(LatencyProbe::Total, 0.95f),
+            G.latency.percentile(LatencyProbe::Total, 0.99f), G.latency.percentile(LatencyProbe::Queue, 0.50f),
+            G.latency.percentile(LatencyProbe::Simulate, 0.50f), G.latency.percentile(LatencyProbe::Render, 0.50f),
+            G.latency.percentile(LatencyProbe::Present, 0.50f));
+    }
+    if (G.capture.active) {
+        len += std::snprintf(buf + len, sizeof(buf) - len, "\nCapture: %d written  %d dropped",
+            G.capture.framesWritten.load(), G.capture.framesDropped);
+    }
+    len += std::snprintf(buf + len, sizeof(buf) - len, "\nMemory: %.1f MB heap (lvl %.2f ter %.2f rnd %.1f font %.1f inp %.2f tel %.2f)  RSS %.1f MB%s",
+        memMB(g_memory.total.load()), memMB(g_memory.live[MemLevel].load()), memMB(g_memory.live[MemTerrain].load()),
+        memMB(g_memory.live[MemRender].load()), memMB(g_memory.live[MemFont].load()), memMB(g_memory.live[MemInputLog].load()),
+        memMB(g_memory.live[MemTelemetry].load()), memMB(static_cast<long long>(G.statRss_bytes)),
+        g_memory.trackPeaks.load() ? "  [peaks]" : "");
+    len += std::snprintf(buf + len, sizeof(buf) - len, "\nLevel: %s in %.2f ms",
+        G.statLevelPrefetched ? "prefetched, swapped" : "built", G.statLevelBuild_ms);
+    len += std::snprintf(buf + len, sizeof(buf) - len, "\nParticles: %d  %.3f ms (budget %.3f)  spawn %.0f%%",
+        static_cast<int>(G.particles.count), G.particles.cost_ms, PARTICLE_BUDGET_MS, G.particles.spawnScale * 100.0f);
+
+    TextBatch& t = G.statsText;
+    t.layout(buf, 0.0f, 20.0f);
+    t.offset(WINDOW_W - t.width - 20.0f, 0.0f);
+    t.draw(win);
+}
+
+// Memory report (F7): live heap bytes per tag, the level arena, process RSS,
+// and per-screen high-water marks while peak tracking is on (F6, --mem-peaks)
+static const char* MEM_SCREEN_NAMES[MEM_SCREENS] = { "menu", "playing", "game over", "level complete", "exit", "game completed", "daily result" };
+
+// Charges this frame to the screen being shown and folds current usage into its peaks
+void sampleMemoryPeaks(Screen screen) {
+    int s = static_cast<int>(screen);
+    g_memory.screen.store(s, std::memory_order_relaxed);
+    if (!g_memory.trackPeaks.load(std::memory_order_relaxed)) return;
+    raisePeak(g_memory.peakTotal[s], g_memory.total.load(std::memory_order_relaxed));
+    for (int t = 0; t < MemTagCount; t++)
+        raisePeak(g_memory.peak[s][t], g_memory.live[t].load(std::memory_order_relaxed));
+}
+
+void setMemoryPeakTracking(bool on) {
+    if (on) {
+        for (int s = 0; s < MEM_SCREENS; s++) {
+            g_memory.peakTotal[s].store(0);
+            for (auto& p : g_memory.peak[s]) p.store(0);
+        }
+    }
+    g_memory.trackPeaks.store(on);
+}
+
+void printMemoryReport(const Game& G) {
+    MemTagScope tag(MemTelemetry);
+    long long total = g_memory.total.load();
+    size_t rss = processRssBytes();
+    std::cout << std::fixed << std::setprecision(2)
+              << "Memory: " << memMB(total) << " MB live on the heap, RSS " << memMB(static_cast<long long>(rss)) << " MB";
+    if (rss > 0)
+        std::cout << " (" << memMB(static_cast<long long>(rss) - total) << " MB outside operator new: code, driver, FreeType, C runtime)";
+    std::cout << std::endl;
+    for (int t = 0; t < MemTagCount; t++)
+        std::cout << "  " << std::setw(10) << MEM_TAG_NAMES[t] << "  " << std::setw(8) << memMB(g_memory.live[t].load()) << " MB" << std::endl;
+    const LevelArena& arena = G.level->arena;
+    std::cout << "  level arena: " << arena.used / 1024 << " / " << arena.capacity / 1024 << " KB used, high water "
+              << arena.highWater / 1024 << " KB, " << arena.regrows << " regrows, " << arena.spills << " spills, "
+              << G.level->terrain.outgrown << " terrain chunks outgrown by tuning reloads" << std::endl;
+
+    if (!g_memory.trackPeaks.load()) return;
+    std::cout << "Peak heap by screen (MB):" << std::endl << "  " << std::setw(15) << "screen" << std::setw(9) << "total";
+    for (int t = 0; t < MemTagCount; t++) std::cout << std::setw(10) << MEM_TAG_NAMES[t];
+    std::cout << std::endl;
+    for (int s = 0; s < MEM_SCREENS; s++) {
+        if (g_memory.peakTotal[s].load() == 0) continue;
+        std::cout << "  " << std::setw(15) << MEM_SCREEN_NAMES[s] << std::setw(9) << memMB(g_memory.peakTotal[s].load());
+        for (int t = 0; t < MemTagCount; t++) std::cout << std::setw(10) << memMB(g_memory.peak[s][t].load());
+        std::cout << std::endl;
+    }
+}
+
+// Pickups are batched into one triangle list. Coins lose segments as the LOD
+// tier rises, so zooming out doesn't multiply vertex counts or draw calls.
+void drawPickups(sf::RenderTarget& win, Game& G, float xStart, float xEnd) {
+    static const int COIN_SEGMENTS[TERRAIN_LOD_TIERS] = { 12, 8, 4, 4 };
+    std::vector<sf::Vertex>& verts = G.pickupVerts;
+    verts.clear();
+
+    auto quad = [&](float cx, float cy, float hw, float hh, sf::Color col) {
+        sf::Vector2f a(cx - hw, cy - hh), b(cx + hw, cy - hh), c(cx + hw, cy + hh), d(cx - hw, cy + hh);
+        verts.push_back(sf::Vertex(a, col)); verts.push_back(sf::Vertex(b, col)); verts.push_back(sf::Vertex(c, col));
+        verts.push_back(sf::Vertex(a, col)); verts.push_back(sf::Vertex(c, col)); verts.push_back(sf::Vertex(d, col));
+    };
+
+    // Fuel cans
+    for (const auto& c : G.level->cans) {
+        if (c.taken) continue;
+        if (c.x_px < xStart - 50 || c.x_px > xEnd + 50) continue;
+        auto gs = sampleGround(c.x_px, *G.level);
+        quad(c.x_px, gs.y - 18.0f, 9.0f, 11.0f, sf::Color::Red);
+    }
+
+    // Coins
+    const int segs = COIN_SEGMENTS[G.lodTier];
+    const float r = 8.0f;
+    for (const auto& coin : G.level->coins) {
+        if (coin.taken) continue;
+        if (coin.x_px < xStart - 50 || coin.x_px > xEnd + 50) continue;
+        sf::Vector2f center(coin.x_px, coin.y_px);
+        for (int i = 0; i < segs; i++) {
+            float a0 = 6.2831853f * i / segs, a1 = 6.2831853f * (i + 1) / segs;
+            verts.push_back(sf::Vertex(center, sf::Color::Green));
+            verts.push_back(sf::Vertex(center + sf::Vector2f(r * std::cos(a0), r * std::sin(a0)), sf::Color::Green));
+            verts.push_back(sf::Vertex(center + sf::Vector2f(r * std::cos(a1), r * std::sin(a1)), sf::Color::Green));
+        }
+    }
+
+    if (!verts.empty()) win.draw(verts.data(), verts.size(), sf::Triangles);
+}
+
+// ---------------------------- Screens ---------------------------------
+sf::Vector2f mouseInWindow(const sf::RenderWindow& win) {
+    sf::Vector2i m = sf::Mouse::getPosition(win);
+    return sf::Vector2f(static_cast<float>(m.x), static_cast<float>(m.y));
+}
+
+void drawMenu(sf::RenderWindow& win, Game& G) {
+    win.clear(sf::Color::White);
+    if (G.hasFont) {
+        char buf[96];
+        const DailyLevel& d = G.daily;
+        if (d.date == 0)
+            std::snprintf(buf, sizeof(buf), "Daily challenge: generating...");
+        else
+            std::snprintf(buf, sizeof(buf), "Daily challenge %04d-%02d-%02d  level #%08x%s", d.date / 10000, d.date / 100 % 100,
+                d.date % 100, d.hash, d.verified ? "" : "  (unverified build)");
+        G.menuUi.setLabel(MENU_DAILY_LABEL, buf);
+    }
+    G.menuUi.draw(win, mouseInWindow(win));
+}
+
+void drawGameOver(sf::RenderWindow& win, Game& G) {
+    win.clear(sf::Color::White);
+    if (!G.hasFont) return;
+
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+        "Distance travelled: %.1fm\nCoins obtained: %d",
+        G.totalDistance_m, G.totalCoins);
+    G.gameOverUi.setLabel(UI_STATS_LABEL, buf);
+    G.gameOverUi.draw(win, mouseInWindow(win));
+
+    // Overview of the level a retry starts
+    G.thumbnails.draw(win, G.currentLevel, 340.0f, 270.0f, 600.0f, 60.0f);
+}
+
+void drawLevelCompleteMenu(sf::RenderWindow& win, Game& G) {
+    win.clear(sf::Color::White);
+    if (!G.hasFont) return;
+
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+        "Level %d\nDistance: %.1fm\nCoins: %d",
+        G.currentLevel + 1, G.levelDistance_m, G.coinsCollected);
+    G.levelCompleteUi.setLabel(UI_STATS_LABEL, buf);
+    G.levelCompleteUi.draw(win, mouseInWindow(win));
+
+    // Overview of the next level once it is unlocked
+    int nextLevel = std::min(G.currentLevel + 1, 4);
+    if (nextLevel < G.unlockedLevels)
+        G.thumbnails.draw(win, nextLevel, 340.0f, 270.0f, 600.0f, 60.0f);
+}
+
+void drawGameCompletedMenu(sf::RenderWindow& win, Game& G) {
+    win.clear(sf::Color::White);
+    if (!G.hasFont) return;
+
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+        "Total Distance: %.1fm\nTotal Coins: %d",
+        G.totalDistance_m, G.totalCoins);
+    G.gameCompletedUi.setLabel(UI_STATS_LABEL, buf);
+    G.gameCompletedUi.draw(win, mouseInWindow(win));
+}
+
+void drawDailyResult(sf::RenderWindow& win, Game& G) {
+    win.clear(sf::Color::White);
+    if (!G.hasFont) return;
+
+    char buf[256];
+    const DailyLevel& d = G.daily;
+    std::snprintf(buf, sizeof(buf),
+        "%04d-%02d-%02d  %s\nDistance: %.1fm of %.0fm\nCoins: %d",
+        d.date / 10000, d.date / 100 % 100, d.date % 100, G.dailyFinished ? "Finished!" : "Run over",
+        G.levelDistance_m, G.level->length_m, G.coinsCollected);
+    G.dailyResultUi.setLabel(UI_STATS_LABEL, buf);
+    G.dailyResultUi.draw(win, mouseInWindow(win));
+}
+
+// Runs a menu action picked by a click
+void applyUiAction(Game& G, UiAction action) {
+    switch (action) {
+    case UiAction::Play:
+        G.screen = Screen::Playing;
+        G.resetGame();
+        break;
+    case UiAction::Exit:
+        G.screen = Screen::Exit; // the exit screen closes the window
+        break;
+    case UiAction::PrevLevel:
+        G.buildLevel(std::max(G.currentLevel - 1, 0));
+        G.screen = Screen::Playing;
+        break;
+    case UiAction::Retry:
+        if (G.playingDaily) G.startDaily();
+        else G.buildLevel(G.currentLevel);
+        G.screen = Screen::Playing;
+        break;
+    case UiAction::NextLevel: {
+        int next = std::min(G.currentLevel + 1, 4);
+        if (next < G.unlockedLevels) {
+            G.buildLevel(next);
+            G.screen = Screen::Playing;
+        }
+        break;
+    }
+    case UiAction::MainMenu:
+        G.screen = Screen::Menu;
+        break;
+    case UiAction::Daily:
+        if (G.daily.date != 0) { // ignored while it is still generating
+            G.startDaily();
+            G.screen = Screen::Playing;
+        }
+        break;
+    case UiAction::None:
+        break;
+    }
+}
+
+// Runs the fixed physics steps the accumulator holds while a level is played
+void simulatePlaying(Game& G, float& accumulator, sf::Int64 frameNow_us) {
+    AllocScope scope(AllocPhysics);
+    while (accumulator >= DT_FIXED) {
+        if (G.screen != Screen::Playing)
+            break; // Stop updating if not playing
+
+        // This step covers simulated time up to frameNow - (accumulator - DT)
+        applyInputs(G, frameNow_us - static_cast<sf::Int64>((accumulator - DT_FIXED) * 1e6f));
+        RunOutcome outcome = stepRun(G, *G.level, DT_FIXED, &G.particles);
+        G.latency.onStepDone();
+        G.tick++;
+        emitVehicleEffects(G, DT_FIXED);
+
+        // Daily runs are scored on their own and leave level progress alone
+        if (G.playingDaily && outcome != RunOutcome::Running) {
+            G.dailyFinished = outcome == RunOutcome::Finished;
+            G.screen = Screen::DailyResult;
+        }
+        // Finish line
+        else if (outcome == RunOutcome::Finished) {
+            G.totalDistance_m += G.levelDistance_m;
+            G.totalCoins += G.coinsCollected;
+
+            int next = G.currentLevel + 1;
+            if (next < 5) {
+                G.unlockedLevels = std::max(G.unlockedLevels, next + 1);
+                // Instead of immediately starting next level, show level complete menu
+                G.screen = Screen::LevelComplete;
+            }
+            else {
+                // All levels complete -> show final score
+                G.screen = Screen::GameCompleted;
+            }
+        }
+        else if (outcome != RunOutcome::Running) {
+            // Fuel timeout or crash -> game over
+            G.totalDistance_m += G.levelDistance_m;
+            G.totalCoins += G.coinsCollected;
+            G.screen = Screen::GameOver;
+        }
+
+        accumulator -= DT_FIXED;
+    }
+}
+
+// Draws the playing screen: the world into the scene target (upscaled when
+// dynamic resolution is on), then the HUD at native resolution
+void renderPlaying(sf::RenderWindow& window, Game& G, sf::View& view, float dt) {
+    sf::RenderTarget& scene = G.resolution.ready ? static_cast<sf::RenderTarget&>(G.resolution.target) : window;
+    scene.clear(sf::Color::White);
+
+    // Camera follows car (clamped within level bounds + margins), zooming out with speed
+    {
+        AllocScope scope(AllocCamera);
+        G.camera.update(G.car, dt);
+        G.camera.apply(view, G.car, G.level->finishX_px);
+        if (G.resolution.ready) view.setViewport(G.resolution.viewport());
+    }
+    {
+        AllocScope scope(AllocBackground);
+        drawBackground(scene, G, view);
+    }
+    scene.setView(view);
+    G.lodTier = terrainLodTier(worldPerPixel(scene));
+    float halfW = view.getSize().x * 0.5f;
+
+    // Draw terrain in view range
+    float xStart = view.getCenter().x - halfW - 50.0f;
+    float xEnd = view.getCenter().x + halfW + 50.0f;
+    {
+        AllocScope scope(AllocTerrain);
+        if (G.shaderTerrain())
+            drawTerrainShader(scene, G, std::max(0.0f, xStart), std::min(G.level->finishX_px + 200.0f, xEnd));
+        else
+            drawTerrain(scene, G, std::max(0.0f, xStart), std::min(G.level->finishX_px + 200.0f, xEnd));
+    }
+
+    // Draw pickups
+    {
+        AllocScope scope(AllocPickups);
+        drawPickups(scene, G, xStart, xEnd);
+    }
+
+    // Dust, exhaust and pickup bursts
+    {
+        AllocScope scope(AllocParticles);
+        G.particles.simulate(dt, G.lodTier);
+        drawParticles(scene, G);
+    }
+
+    // Draw car + man
+    {
+        AllocScope scope(AllocVehicle);
+        drawVehicle(scene, G);
+    }
+
+    // Upscale the scene, then HUD at native resolution
+    AllocScope scope(AllocHud);
+    if (G.resolution.ready) G.resolution.blit(window);
+    window.setView(window.getDefaultView());
+    drawHUD(window, G);
+    {
+        AllocScope minimapScope(AllocMinimap);
+        G.minimap.draw(window, *G.level, G.car);
+    }
+    AllocScope statsScope(AllocStats);
+    drawStats(window, G);
+}
+
+// ---------------------------- Level generator -------------------------
+// Builds a level from a seed: fractal (fBm) value noise for the ground, shaped
+// by designer constraints, then the usual pickup layout. Lattice values come
+// from an integer hash and the octave sum, amplitude ramp and slope limiter all
+// run on whole quarter-pixels, so a seed gives bit-identical ground on every
+// compiler and CPU. An 1100 m level takes a small fraction of a millisecond.
+struct LevelGenParams {
+    float length_m = 1100.0f;
+    int difficulty = 4;           // 0..4: background set, like the designed level of that number
+    float amplitude_px = 110.0f;  // largest hill height at the finish (35% of it at the start)
+    float hillSpacing_m = 64.0f;  // wavelength of the largest hills
+    float minFeature_m = 4.0f;    // octaves stop before bumps get narrower than this
+    float maxSlope = 0.85f;       // steepest |dy/dx| the limiter lets through (about 40 degrees)
+    float startFlat_m = 12.0f;    // level ground under the spawn point
+};
+
+inline sf::Uint32 noiseHash(sf::Uint32 seed, sf::Uint32 octave, sf::Uint32 cell) {
+    sf::Uint32 h = seed * 0x9E3779B1u ^ octave * 0x85EBCA77u ^ cell * 0xC2B2AE3Du;
+    h ^= h >> 15; h *= 0x2C1B3C6Du;
+    h ^= h >> 12; h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return h;
+}
+
+void generateLevelData(Level& level, sf::Uint32 seed, const LevelGenParams& gen = LevelGenParams()) {
+    MemTagScope tag(MemLevel);
+    level.clear();
+    level.index = std::clamp(gen.difficulty, 0, 4);
+    level.seed = seed;
+    level.length_m = gen.length_m;
+    level.length_px = m2px(level.length_m);
+    level.finishX_px = level.length_px;
+    const float extent_px = level.finishX_px + 400.0f; // terrain is drawn up to 200 px past the finish
+    level.terrain.reset(level.index, extent_px);
+
+    const int samples = static_cast<int>(std::ceil(extent_px / HEIGHTFIELD_STEP_PX)) + 2;
+    const int metersPerSample = static_cast<int>(HEIGHTFIELD_STEP_PX / PPM);
+    const int wave0 = std::max(2, static_cast<int>(gen.hillSpacing_m) / metersPerSample);
+    const int minWave = std::max(2, static_cast<int>(gen.minFeature_m) / metersPerSample);
+    const sf::Int64 amplitude_q = static_cast<sf::Int64>(gen.amplitude_px * 4.0f); // quarter-px
+    const int maxStep_q = std::max(1, static_cast<int>(gen.maxSlope * HEIGHTFIELD_STEP_PX * 4.0f));
+    const int flat = std::min(samples - 1, static_cast<int>(m2px(gen.startFlat_m) / HEIGHTFIELD_STEP_PX));
+
+    // Heights are held as whole quarter-pixels (exact in a float) until the last pass
+    std::pmr::vector<float>& h = level.field.y;
+    h.resize(samples);
+    for (int i = 0; i < samples; i++) {
+        sf::Int64 sum = 0; // Q15 per octave, each octave half the last
+        int octave = 0;
+        for (int wave = wave0; wave >= minWave; wave /= 2, octave++) {
+            sf::Uint32 cell = static_cast<sf::Uint32>(i / wave);
+            sf::Int64 t = (static_cast<sf::Int64>(i % wave) << 16) / wave;  // Q16
+            sf::Int64 s = (t * t >> 16) * (3 * 65536 - 2 * t) >> 16;        // smoothstep, Q16
+            sf::Int64 a = static_cast<sf::Int64>(noiseHash(seed, octave, cell) >> 16) - 32768;
+            sf::Int64 b = static_cast<sf::Int64>(noiseHash(seed, octave, cell + 1) >> 16) - 32768;
+            sum += (a + ((b - a) * s >> 16)) >> octave;
+        }
+        sf::Int64 ramp = 90 + 166 * static_cast<sf::Int64>(i) / samples; // Q8, 0.35 .. 1.0
+        h[i] = static_cast<float>(sum * amplitude_q * ramp / (65536 * 256));
+    }
+
+    // Flat spawn pad, then limit the slope left to right (every step within maxSlope)
+    for (int i = 0; i < flat; i++) h[i] = h[flat];
+    for (int i = 1; i < samples; i++)
+        h[i] = std::clamp(h[i], h[i - 1] - maxStep_q, h[i - 1] + maxStep_q);
+
+    const float base = WINDOW_H * g_tuning.groundBase;
+    for (float& y : h) y = base - y * 0.25f; // up is smaller y
+
+    placePickups(level);
+}
+
+// Batch generation: --generate-levels [count] [first seed]
+// Generates candidate levels on every core and writes one CSV row per seed
+// (generation time, steepest slope, total climb, relief) for offline curation.
+static const char* GENERATED_LEVELS_CSV = "generated_levels.csv";
+
+int runLevelGenerator(int count, sf::Uint32 firstSeed) {
+    struct Row { sf::Int64 gen_us; float maxSlope, climb_m, relief_m; };
+    std::vector<Row> rows(count);
+    std::atomic<int> next{ 0 };
+    sf::Clock timer;
+
+    auto worker = [&] {
+        Level level; // arena reused from one seed to the next
+        for (int i = next++; i < count; i = next++) {
+            sf::Int64 start = nowUs();
+            generateLevelData(level, firstSeed + static_cast<sf::Uint32>(i));
+            Row& r = rows[i];
+            r.gen_us = nowUs() - start;
+            r.maxSlope = r.climb_m = 0.0f;
+            const std::pmr::vector<float>& h = level.field.y;
+            auto [lo, hi] = std::minmax_element(h.begin(), h.end());
+            r.relief_m = px2m(*hi - *lo);
+            for (size_t k = 1; k < h.size(); k++) {
+                float rise = h[k - 1] - h[k];
+                r.maxSlope = std::max(r.maxSlope, std::fabs(rise) / HEIGHTFIELD_STEP_PX);
+                if (rise > 0.0f) r.climb_m += px2m(rise);
+            }
+        }
+    };
+    unsigned threads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), count));
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+    double wall_ms = timer.getElapsedTime().asMicroseconds() / 1000.0;
+
+    FILE* csv = std::fopen(GENERATED_LEVELS_CSV, "w");
+    if (!csv) {
+        std::cout << "Cannot write " << GENERATED_LEVELS_CSV << std::endl;
+        return 1;
+    }
+    std::fprintf(csv, "seed,gen_us,max_slope,climb_m,relief_m\n");
+    for (int i = 0; i < count; i++)
+        std::fprintf(csv, "%u,%lld,%.3f,%.1f,%.1f\n", firstSeed + static_cast<sf::Uint32>(i),
+            static_cast<long long>(rows[i].gen_us), rows[i].maxSlope, rows[i].climb_m, rows[i].relief_m);
+    std::fclose(csv);
+
+    std::vector<sf::Int64> times(count);
+    for (int i = 0; i < count; i++) times[i] = rows[i].gen_us;
+    std::sort(times.begin(), times.end());
+    std::cout << "Generated " << count << " levels (" << LevelGenParams().length_m << " m) in " << std::fixed
+              << std::setprecision(1) << wall_ms << " ms on " << threads << " threads: median "
+              << times[count / 2] << " us, p99 " << times[std::min(count - 1, count * 99 / 100)] << " us per level, "
+              << std::setprecision(0) << count / (wall_ms / 1000.0) << " levels/s -> " << GENERATED_LEVELS_CSV << std::endl;
+    return 0;
+}
+
+// ---------------------------- Level overviews -------------------------
+// Offline tool: rasterizes a full-length overview of each level (terrain
+// profile, fuel cans, coins, finish line) into a CPU image and writes PNGs.
+// No window or GPU is involved, and levels are rendered on all cores. The
+// designed levels feed the result screen thumbnails; a batch of generated
+// seeds can be rendered the same way for curation.
+void rasterizeOverview(const Level& level, std::vector<sf::Uint8>& rgba, unsigned w, unsigned h) {
+    rgba.assign(static_cast<size_t>(w) * h * 4, 255);
+    auto plot = [&](int x, int y, sf::Color c) {
+        if (x < 0 || y < 0 || x >= static_cast<int>(w) || y >= static_cast<int>(h)) return;
+        sf::Uint8* p = &rgba[(static_cast<size_t>(y) * w + x) * 4];
+        p[0] = c.r; p[1] = c.g; p[2] = c.b; p[3] = c.a;
+    };
+
+    // Horizontal: level plus the 200 px drawn past the finish. Vertical: the
+    // terrain's height range with room above for coins.
+    const float extent = level.finishX_px + 200.0f;
+    const float pxPerCol = extent / w;
+    float yMin = 1e9f, yMax = -1e9f;
+    std::vector<float> colTop(w);
+    for (unsigned col = 0; col < w; col++) {
+        // Highest point within the column so narrow peaks survive
+        float top = 1e9f;
+        for (int k = 0; k < 4; k++) top = std::min(top, sampleGround((col + k / 4.0f) * pxPerCol, level).y);
+        colTop[col] = top;
+        yMin = std::min(yMin, top);
+        yMax = std::max(yMax, top);
+    }
+    const float worldTop = yMin - 80.0f, worldBottom = yMax + 20.0f;
+    const float scaleY = h / (worldBottom - worldTop);
+    auto rowOf = [&](float y) { return static_cast<int>((y - worldTop) * scaleY); };
+
+    for (unsigned col = 0; col < w; col++)
+        for (int row = std::max(0, rowOf(colTop[col])); row < static_cast<int>(h); row++)
+            plot(col, row, sf::Color::Black);
+
+    int finishCol = static_cast<int>(level.finishX_px / pxPerCol);
+    for (unsigned row = 0; row < h; row += 2) plot(finishCol, row, sf::Color(0, 120, 255));
+
+    for (const auto& c : level.cans) {
+        int cx = static_cast<int>(c.x_px / pxPerCol), cy = rowOf(sampleGround(c.x_px, level).y - 18.0f);
+        for (int dy = -3; dy <= 3; dy++) for (int dx = -2; dx <= 2; dx++) plot(cx + dx, cy + dy, sf::Color::Red);
+    }
+    for (const auto& coin : level.coins) {
+        int cx = static_cast<int>(coin.x_px / pxPerCol), cy = rowOf(coin.y_px);
+        for (int dy = -2; dy <= 2; dy++) for (int dx = -2; dx <= 2; dx++)
+            if (dx * dx + dy * dy <= 5) plot(cx + dx, cy + dy, sf::Color::Green);
+    }
+}
+
+// Generated level overviews are named by seed, apart from the thumbnails
+std::string generatedOverviewPath(const std::string& dir, sf::Uint32 seed) {
+    return dir + "/generated_" + std::to_string(seed) + ".png";
+}
+
+// --render-overviews [dir] [count] [first seed]
+// Without a count renders the five designed levels; with one, that many
+// generated levels from the first seed (as --generate-levels numbers them).
+int runOverviewRenderer(const std::string& dir, int generated, sf::Uint32 firstSeed) {
+    readLevelBake(LEVEL_BAKE_FILE, g_levelBake); // baked cans, as the game places them
+    std::filesystem::create_directories(dir);
+    const int count = generated > 0 ? generated : 5;
+    std::atomic<int> next{ 0 }, failed{ 0 };
+    sf::Clock timer;
+
+    auto worker = [&] {
+        Level level;
+        std::vector<sf::Uint8> rgba;
+        sf::Image image;
+        for (int i = next++; i < count; i = next++) {
+            sf::Uint32 seed = firstSeed + static_cast<sf::Uint32>(i);
+            if (generated > 0) generateLevelData(level, seed);
+            else buildLevelData(level, i);
+            rasterizeOverview(level, rgba, OVERVIEW_W, OVERVIEW_H);
+            image.create(OVERVIEW_W, OVERVIEW_H, rgba.data());
+            if (!image.saveToFile(generated > 0 ? generatedOverviewPath(dir, seed) : overviewPath(dir, i))) failed++;
+        }
+    };
+    unsigned threads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), count));
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+
+    std::cout << "Rendered " << (count - failed) << (generated > 0 ? " generated" : "") << " level overviews to " << dir << "/ in "
+              << timer.getElapsedTime().asMilliseconds() << " ms on " << threads << " threads" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
+
+// Headless level-transition benchmark: --bench-levels [cycles]
+// Rebuilds each level repeatedly into one Level, as retries do, with every
+// terrain tier tessellated, and reports build time and arena reuse. Returns
+// nonzero if any rebuild after the first still spilled to the heap.
+int runLevelBenchmark(int cycles) {
+    Level level;
+    int lateSpills = 0;
+    sf::Clock timer;
+    for (int idx = 0; idx < 5; idx++) {
+        double first_ms = 0.0, rest_ms = 0.0;
+        int spilled = 0;
+        for (int c = 0; c < cycles; c++) {
+            timer.restart();
+            buildLevelData(level, idx);
+            level.terrain.buildAll();
+            double ms = timer.getElapsedTime().asMicroseconds() / 1000.0;
+            if (c == 0) first_ms = ms; else rest_ms += ms;
+            if (level.arena.spills > 0) {
+                spilled++;
+                if (c > 0) lateSpills++;
+            }
+        }
+        std::cout << "Level " << (idx + 1) << ": first build " << std::fixed << std::setprecision(3) << first_ms
+                  << " ms, rebuild avg " << (cycles > 1 ? rest_ms / (cycles - 1) : 0.0) << " ms, arena "
+                  << level.arena.used / 1024 << " / " << level.arena.capacity / 1024 << " KB, cycles spilling to heap: "
+                  << spilled << "/" << cycles << std::endl;
+    }
+    std::cout << "Arena rewinds: " << level.arena.rewinds << "  regrows: " << level.arena.regrows
+              << "  high water: " << level.arena.highWater / 1024 << " KB" << std::endl;
+    return lateSpills > 0 ? 1 : 0;
+}
 
-    auto fw = V.frontWheelPos();
-    auto rw = V.rearWheelPos();
-    wheel.setPosition(fw); win.draw(wheel);
-    wheel.setPosition(rw); win.draw(wheel);
+// ---------------------------- Daily challenge -------------------------
+// One generated level per UTC day. Its seed and generator parameters come from
+// the date alone and generation is integer-exact (see Level generator), so
+// every copy of the game builds the same level locally, with nothing to
+// download. levelHash() fingerprints the level; the menu shows it so players
+// can compare, and startup checks that this build reproduces a reference
+// day's hash, so a build whose generator drifted is flagged rather than
+// quietly serving a different level.
+static const int DAILY_REFERENCE_DATE = 20260101;
+static const sf::Uint32 DAILY_REFERENCE_HASH = 0x121dbe97u;
+static const sf::Uint32 DAILY_SEED_SALT = 0x0DA11E5Eu;
+
+int utcDateToday() {
+    std::chrono::year_month_day day{ std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now()) };
+    return static_cast<int>(day.year()) * 10000 + static_cast<int>(static_cast<unsigned>(day.month())) * 100 +
+           static_cast<int>(static_cast<unsigned>(day.day()));
+}
 
-    // Chassis (black)
-    sf::RectangleShape body(sf::Vector2f(V.bodyW, V.bodyH));
-    body.setOrigin(V.bodyW * 0.5f, V.bodyH * 0.5f);
-    body.setFillColor(sf::Color::Black);
-    body.setPosition(V.x_px, V.y_px);
-    body.setRotation(V.angle * 180.0f / 3.1415926f);
-    win.draw(body);
+sf::Uint32 dailySeed(int date) { return noiseHash(DAILY_SEED_SALT, 0, static_cast<sf::Uint32>(date)); }
 
-    // Man: simple seat + head; head follows rotation
-    // Seat / torso
-    sf::RectangleShape torso(sf::Vector2f(V.bodyH * 0.6f, V.bodyH * 0.8f));
-    torso.setOrigin(torso.getSize().x * 0.5f, torso.getSize().y);
-    auto seat = V.localToWorld(-V.bodyW * 0.1f, -V.bodyH * 0.1f);
-    torso.setPosition(seat);
-    torso.setRotation(V.angle * 180.0f / 3.1415926f);
-    torso.setFillColor(sf::Color(60, 60, 60));
-    win.draw(torso);
-
-    // Head
-    float headR = V.bodyH * 0.28f;
-    sf::CircleShape head(headR);
-    head.setOrigin(headR, headR);
-    auto headP = V.headPos();
-    head.setPosition(headP);
-    head.setFillColor(sf::Color(80, 80, 80));
-    win.draw(head);
-}
-
-void drawHUD(sf::RenderWindow& win, const Game& G) {
-    // Background is white; draw black HUD elements
-    // Fuel bar
-    float barW = 280.0f, barH = 18.0f;
-    sf::RectangleShape outline(sf::Vector2f(barW, barH));
-    outline.setPosition(20.0f, 20.0f);
-    outline.setFillColor(sf::Color::Transparent);
-    outline.setOutlineColor(sf::Color::Black);
-    outline.setOutlineThickness(2.0f);
-    win.draw(outline);
-
-    float pct = clampf(G.fuel_m / FUEL_TANK_METERS, 0.0f, 1.0f);
-    sf::RectangleShape fill(sf::Vector2f(barW * pct, barH));
-    fill.setPosition(20.0f, 20.0f);
-    fill.setFillColor(sf::Color::Black);
-    win.draw(fill);
+// Background set, length and hill height vary with the seed
+LevelGenParams dailyParams(sf::Uint32 seed) {
+    LevelGenParams gen;
+    gen.difficulty = static_cast<int>(seed % 5);
+    gen.length_m = 700.0f + 100.0f * gen.difficulty;
+    gen.amplitude_px = 70.0f + 10.0f * gen.difficulty;
+    return gen;
+}
 
-    if (G.hasFont) {
-        // Distance & coins
-        sf::Text t;
-        t.setFont(G.font);
-        t.setCharacterSize(18);
-        t.setFillColor(sf::Color::Black);
+// FNV-1a over what makes the level: seed, length, ground in whole
+// quarter-pixels relative to the spawn pad (so the tuning's ground base drops
+// out) and coin placement. Fuel cans are left out; they follow the local
+// tuning's can spacing.
+sf::Uint32 levelHash(const Level& level) {
+    sf::Uint32 h = 2166136261u;
+    auto mix = [&](sf::Int64 value) {
+        sf::Uint64 v = static_cast<sf::Uint64>(value);
+        for (int b = 0; b < 8; b++, v >>= 8) {
+            h ^= static_cast<sf::Uint32>(v & 0xFFu);
+            h *= 16777619u;
+        }
+    };
+    mix(level.seed);
+    mix(level.index);
+    mix(std::llround(level.length_px));
+    const std::pmr::vector<float>& y = level.field.y;
+    mix(static_cast<sf::Int64>(y.size()));
+    for (float v : y) mix(std::llround((y.front() - v) * 4.0f));
+    for (const Coin& c : level.coins) {
+        mix(std::llround(c.x_px));
+        mix(std::llround(c.hover_px));
+    }
+    return h;
+}
 
-        char buf[128];
-        std::snprintf(buf, sizeof(buf), "Level %d  Dist: %.1fm  Coins: %d", G.currentLevel + 1, G.levelDistance_m, G.coinsCollected);
-        t.setString(buf);
-        t.setPosition(20.0f, 46.0f);
-        win.draw(t);
+// Generates the date's level with every terrain tier tessellated and its
+// background laid out, then regenerates the reference day to verify the
+// generator. Touches no game or GPU state, so startup runs it on a worker.
+void prepareDaily(DailyLevel& out, int date) {
+    MemTagScope tag(MemLevel);
+    out.date = date;
+    out.seed = dailySeed(date);
+    Level& level = *out.prepared.level;
+    generateLevelData(level, out.seed, dailyParams(out.seed));
+    level.terrain.buildAll();
+    Background::layoutLevel(level.index, out.prepared.layers);
+    out.hash = levelHash(level);
+
+    Level reference;
+    sf::Uint32 seed = dailySeed(DAILY_REFERENCE_DATE);
+    generateLevelData(reference, seed, dailyParams(seed));
+    out.verified = levelHash(reference) == DAILY_REFERENCE_HASH;
+}
+
+// Daily check: --daily [yyyymmdd]
+// Prints a day's seed and level hash (to compare across machines and builds)
+// and exits nonzero if this build does not reproduce the reference day.
+int runDailyCheck(int date) {
+    sf::Int64 start = nowUs();
+    DailyLevel daily;
+    prepareDaily(daily, date);
+    double prepare_ms = (nowUs() - start) / 1000.0;
+
+    const Level& level = *daily.prepared.level;
+    char line[256];
+    std::snprintf(line, sizeof(line), "Daily %04d-%02d-%02d: seed %u, %.0f m, background %d, hash %08x, prepared in %.2f ms",
+        date / 10000, date / 100 % 100, date % 100, daily.seed, level.length_m, level.index + 1, daily.hash, prepare_ms);
+    std::cout << line << std::endl;
+    if (daily.verified) {
+        std::cout << "  reference day " << DAILY_REFERENCE_DATE << " reproduced" << std::endl;
+        return 0;
     }
+    Level reference;
+    sf::Uint32 seed = dailySeed(DAILY_REFERENCE_DATE);
+    generateLevelData(reference, seed, dailyParams(seed));
+    std::snprintf(line, sizeof(line), "  reference day %d hashes to %08x, expected %08x: this build's daily levels differ from other builds",
+        DAILY_REFERENCE_DATE, levelHash(reference), DAILY_REFERENCE_HASH);
+    std::cout << line << std::endl;
+    return 1;
 }
 
-void drawPickups(sf::RenderWindow& win, const Game& G, float xStart, float xEnd) {
-    // Fuel cans
-    for (const auto& c : G.level.cans) {
-        if (c.taken) continue;
-        if (c.x_px < xStart - 50 || c.x_px > xEnd + 50) continue;
-        auto gs = sampleGround(c.x_px, G.currentLevel);
-        sf::RectangleShape can(sf::Vector2f(18.0f, 22.0f));
-        can.setOrigin(9.0f, 11.0f);
-        can.setPosition(c.x_px, gs.y - 18.0f);
-        can.setFillColor(sf::Color::Red);
-        win.draw(can);
+// ---------------------------- Tuning file -----------------------------
+// tuning.cfg holds "key = value" lines ('#' starts a comment) overriding the
+// Tuning defaults; keys left out keep their default. A watcher thread polls
+// the file's modification time and parses a changed file off the main thread;
+// the main loop applies the result at the top of a frame, between physics
+// steps, and invalidates only what the changed values feed.
+static const char* TUNING_FILE = "tuning.cfg";
+static const int   TUNING_POLL_MS = 250;
+
+struct TuningKey { const char* name; float Tuning::* field; };
+static const TuningKey TUNING_KEYS[] = {
+    { "gravity", &Tuning::gravity },
+    { "accel", &Tuning::accel },
+    { "torque", &Tuning::torque },
+    { "slope_align_rate", &Tuning::slopeAlignRate },
+    { "ground_friction", &Tuning::groundFriction },
+    { "ground_friction_no_fuel", &Tuning::groundFrictionNoFuel },
+    { "ground_angular_damping", &Tuning::groundAngularDamping },
+    { "air_drag", &Tuning::airDrag },
+    { "air_angular_damping", &Tuning::airAngularDamping },
+    { "fuel_tank_m", &Tuning::fuelTankMeters },
+    { "fuel_can_gap_m", &Tuning::fuelCanGapMeters },
+    { "ground_base", &Tuning::groundBase },
+    { "rough_base", &Tuning::roughBase },
+    { "rough_per_level", &Tuning::roughPerLevel },
+    { "freq1_base", &Tuning::freq1Base },
+    { "freq1_per_level", &Tuning::freq1PerLevel },
+    { "freq2_base", &Tuning::freq2Base },
+    { "freq2_per_level", &Tuning::freq2PerLevel },
+};
+
+// Parses a tuning file over the defaults; false if it cannot be opened.
+// Malformed lines and unknown keys are reported and skipped.
+bool readTuningFile(const std::string& path, Tuning& out) {
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) return false;
+    out = Tuning{};
+    char line[256];
+    for (int lineNo = 1; std::fgets(line, sizeof(line), file); lineNo++) {
+        if (char* hash = std::strchr(line, '#')) *hash = '\0';
+        char key[64];
+        float value = 0.0f;
+        int fields = std::sscanf(line, " %63[A-Za-z0-9_] = %f", key, &value);
+        if (fields <= 0) continue; // blank or comment
+        const TuningKey* match = nullptr;
+        for (const TuningKey& k : TUNING_KEYS)
+            if (std::strcmp(k.name, key) == 0) match = &k;
+        if (fields != 2 || !match || !std::isfinite(value)) {
+            std::cout << path << ":" << lineNo << ": ignored '" << key << "'"
+                      << (match ? " (expected key = number)" : " (unknown key)") << std::endl;
+            continue;
+        }
+        out.*(match->field) = value;
     }
+    std::fclose(file);
+    return true;
+}
 
-    // Coins
-    for (const auto& coin : G.level.coins) {
-        if (coin.taken) continue;
-        if (coin.x_px < xStart - 50 || coin.x_px > xEnd + 50) continue;
-        sf::CircleShape c(8.0f, 12);
-        c.setOrigin(8.0f, 8.0f);
-        c.setPosition(coin.x_px, coin.y_px);
-        c.setFillColor(sf::Color::Green);
-        win.draw(c);
+// Tuning file: --write-tuning [path] writes the defaults as a starting point
+int writeTuningFile(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cout << "Cannot write " << path << std::endl;
+        return 1;
+    }
+    const Tuning defaults;
+    std::fprintf(file, "# Black And White Racing tuning; saved changes apply while the game runs\n");
+    for (const TuningKey& k : TUNING_KEYS) {
+        float value = defaults.*(k.field);
+        char text[32];
+        for (int digits = 6; digits <= 9; digits++) { // shortest text that reads back exactly
+            std::snprintf(text, sizeof(text), "%.*g", digits, value);
+            if (std::strtof(text, nullptr) == value) break;
+        }
+        std::fprintf(file, "%s = %s\n", k.name, text);
     }
+    std::fclose(file);
+    std::cout << "Wrote " << path << std::endl;
+    return 0;
 }
 
-// ---------------------------- Screens ---------------------------------
-void drawMenu(sf::RenderWindow& win, Game& G) {
-    win.clear(sf::Color::White);
+// Polls the file's modification time; a changed file is parsed on the
+// watcher thread and handed to the main thread through take()
+struct TuningWatcher {
+    std::string path;
+    std::filesystem::file_time_type lastWrite{};
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::atomic<bool> pending{ false };
+    Tuning staged;
+
+    ~TuningWatcher() { stop(); }
+
+    // Loads the file synchronously (so level 1 is built with it), then watches
+    void start(const std::string& file) {
+        path = file;
+        std::error_code ec;
+        lastWrite = std::filesystem::last_write_time(path, ec);
+        if (readTuningFile(path, g_tuning)) std::cout << "Tuning: loaded " << path << std::endl;
+        worker = std::thread(&TuningWatcher::run, this);
+    }
 
-    if (G.hasFont) {
-        // Draw title
-        sf::Text title("Black And White Racing", G.font, 42);
-        title.setFillColor(sf::Color::Black);
-        title.setPosition((WINDOW_W - title.getLocalBounds().width) / 2, 80);
-        win.draw(title);
-
-        // Update button hover state
-        sf::Vector2i mousePos = sf::Mouse::getPosition(win);
-        G.playButton.hovered = G.playButton.rect.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y));
-        G.exitButton.hovered = G.exitButton.rect.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y));
-
-        // Adjust button colors for hover effect
-        G.playButton.rect.setFillColor(G.playButton.hovered ? sf::Color(0, 80, 200) : sf::Color(0, 120, 255));
-        G.exitButton.rect.setFillColor(G.exitButton.hovered ? sf::Color(0, 80, 200) : sf::Color(0, 120, 255));
-
-        // Draw buttons
-        win.draw(G.playButton.rect);
-        win.draw(G.playButton.text);
-        win.draw(G.exitButton.rect);
-        win.draw(G.exitButton.text);
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) worker.join();
     }
-    else {
-        // Fallback if font fails to load
-        sf::Text fallback("Click top half to Play\nClick bottom half to Exit", G.font, 28);
-        fallback.setFillColor(sf::Color::Black);
-        fallback.setPosition((WINDOW_W - fallback.getLocalBounds().width) / 2, (WINDOW_H - fallback.getLocalBounds().height) / 2);
-        win.draw(fallback);
+
+    bool take(Tuning& out) {
+        if (!pending.load(std::memory_order_acquire)) return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        out = staged;
+        pending.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!wake.wait_for(lock, std::chrono::milliseconds(TUNING_POLL_MS), [&] { return stopping; })) {
+            lock.unlock();
+            std::error_code ec;
+            auto stamp = std::filesystem::last_write_time(path, ec);
+            Tuning parsed;
+            bool changed = !ec && stamp != lastWrite;
+            if (changed) {
+                lastWrite = stamp;
+                changed = readTuningFile(path, parsed); // editors may still hold the file; retried next change
+            }
+            lock.lock();
+            if (changed) {
+                staged = parsed;
+                pending.store(true, std::memory_order_release);
+            }
+        }
     }
+};
 
-    win.display();
+// Swaps in a new tuning between physics steps. Physics and fuel values take
+// effect on the next step; the current level's terrain chunks, coin heights
+// and minimap are redone only if its curve changed, its cans only if the gap
+// did; baked cans and coins give way to the fixed layout, measured under
+// other rules.
+void applyTuning(Game& G, const Tuning& next) {
+    int changed = 0;
+    for (const TuningKey& k : TUNING_KEYS)
+        if (g_tuning.*(k.field) != next.*(k.field)) changed++;
+    if (changed == 0) return;
+
+    Level& level = *G.level;
+    TerrainParams before = terrainParams(level.index);
+    float oldGap = g_tuning.fuelCanGapMeters;
+    bool bakedCans = g_levelBake.cansFor(level) != nullptr, bakedCoins = g_levelBake.coinsFor(level) != nullptr;
+    g_tuning = next;
+    TerrainParams after = terrainParams(level.index);
+    bool terrainChanged = std::memcmp(&before, &after, sizeof(TerrainParams)) != 0;
+    bool cansChanged = oldGap != g_tuning.fuelCanGapMeters || bakedCans != (g_levelBake.cansFor(level) != nullptr);
+    bool coinsChanged = bakedCoins != (g_levelBake.coinsFor(level) != nullptr);
+
+    G.prefetcher.invalidate(); // prepared levels used the old values
+    G.fuel_m = std::min(G.fuel_m, g_tuning.fuelTankMeters);
+    bool built = level.terrain.levelIndex == level.index;
+    if (built && terrainChanged) {
+        level.terrain.invalidate();
+        settleCoins(level);
+    }
+    if (built && cansChanged) placeFuelCans(level, G.car.x_px);
+    if (built && coinsChanged) placeCoins(level, G.car.x_px);
+    if (built && (terrainChanged || cansChanged)) G.minimap.bake(level);
+
+    std::cout << "Tuning: applied " << changed << " changed value(s)"
+              << (built && terrainChanged ? ", terrain rebuilt" : "")
+              << (built && cansChanged ? ", cans re-laid" : "")
+              << (built && coinsChanged ? ", coins re-laid" : "") << std::endl;
 }
 
-// Modified drawGameOver function
-void drawGameOver(sf::RenderWindow& win, Game& G) {
-    win.clear(sf::Color::White);
+// ---------------------------- Level validator -------------------------
+// Headless check that a level can be finished under the current rules (tank
+// size, can spacing, head hit, fuel-out countdown), driven by stepRun, the
+// same step the game runs. A beam search of bots: every decision window each
+// surviving attempt branches into throttle, coast and reverse held for the
+// window, and the distinct attempts that can reach furthest (position plus
+// fuel left) are kept; a level the beam fails is searched again four times
+// wider before it is called not completable. Levels are validated on all
+// cores. Each reports whether a bot finished it, the best distance any bot
+// reached, and the hardest segment: the stretch where most attempts crashed
+// or ran dry.
+static const int   VALIDATOR_BEAM = 24;          // attempts kept after every window (first pass)
+static const int   VALIDATOR_WINDOW_STEPS = 30;  // 0.25 s per held control
+static const float VALIDATOR_SEGMENT_M = 20.0f;  // hardest-segment resolution
+static const float VALIDATOR_MIN_SPEED_MPS = 2.0f; // time budget: level length at this pace + 60 s
+static const char* VALIDATED_LEVELS_CSV = "validated_levels.csv";
+
+struct LevelVerdict {
+    bool completable = false;
+    float best_m = 0.0f;
+    int hardestSegment = -1; // index of the VALIDATOR_SEGMENT_M stretch, -1 when no bot died
+    int hardestDeaths = 0;
+    int crashes = 0, fuelOuts = 0;
+    long long steps = 0;
+};
 
-    if (G.hasFont) {
-        sf::Text t("Game Over", G.font, 48);
-        t.setFillColor(sf::Color::Black);
-        t.setPosition((WINDOW_W - t.getLocalBounds().width) / 2, 80);
-        win.draw(t);
-
-        char buf[256];
-        std::snprintf(buf, sizeof(buf),
-            "Distance travelled: %.1fm\nCoins obtained: %d",
-            G.totalDistance_m, G.totalCoins);
-        sf::Text s(buf, G.font, 28);
-        s.setFillColor(sf::Color::Black);
-        s.setPosition((WINDOW_W - s.getLocalBounds().width) / 2, 160);
-        win.draw(s);
-
-        sf::Vector2i mousePos = sf::Mouse::getPosition(win);
-        sf::Color arrowNormal = sf::Color::Black;
-        sf::Color arrowHover = sf::Color::Red;
-        sf::Color buttonNormal = sf::Color(0, 120, 255);
-        sf::Color buttonHover = sf::Color(0, 80, 200);
-        sf::Color buttonTextColor = sf::Color::White;
-
-        // Draw left arrow
-        sf::Text leftArrow(sf::String(static_cast<sf::Uint32>(0x2190)), G.font, 60);
-        leftArrow.setFillColor(leftArrow.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? arrowHover : arrowNormal);
-        leftArrow.setPosition(300, 350);
-        win.draw(leftArrow);
-
-        // Draw right arrow
-        /*sf::Text rightArrow(sf::String(static_cast<sf::Uint32>(0x2192)), G.font, 60);
-        rightArrow.setFillColor(rightArrow.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? arrowHover : arrowNormal);
-        rightArrow.setPosition(900, 350);
-        win.draw(rightArrow);*/
-
-        // Draw retry button (middle)
-        sf::RectangleShape retryButton(sf::Vector2f(200.0f, 50.0f));
-        retryButton.setPosition(540.0f, 350.0f);
-        retryButton.setFillColor(retryButton.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? buttonHover : buttonNormal);
-        retryButton.setOutlineColor(sf::Color::Black);
-        retryButton.setOutlineThickness(2.0f);
-        win.draw(retryButton);
-
-        sf::Text retryText("Retry", G.font, 24);
-        retryText.setFillColor(buttonTextColor);
-        sf::FloatRect textBounds = retryText.getLocalBounds();
-        retryText.setPosition(
-            540.0f + (200.0f - textBounds.width) / 2,
-            350.0f + (50.0f - textBounds.height) / 2 - textBounds.top
-        );
-        win.draw(retryText);
-
-        // Draw exit button (lower)
-        sf::RectangleShape exitButton(sf::Vector2f(200.0f, 50.0f));
-        exitButton.setPosition(540.0f, 500.0f);
-        exitButton.setFillColor(exitButton.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? buttonHover : buttonNormal);
-        exitButton.setOutlineColor(sf::Color::Black);
-        exitButton.setOutlineThickness(2.0f);
-        win.draw(exitButton);
-
-        sf::Text exitText("Exit", G.font, 24);
-        exitText.setFillColor(buttonTextColor);
-        textBounds = exitText.getLocalBounds();
-        exitText.setPosition(
-            540.0f + (200.0f - textBounds.width) / 2,
-            500.0f + (50.0f - textBounds.height) / 2 - textBounds.top
-        );
-        win.draw(exitText);
-
-        // Hint (updated to reflect Exit as close, but key remains Backspace for main menu; adjust as needed)
-        sf::Text hint("Left/Right: Change Level   R: Restart   Backspace: Main Menu", G.font, 22);
-        hint.setFillColor(sf::Color::Black);
-        hint.setPosition((WINDOW_W - hint.getLocalBounds().width) / 2, 620);
-        win.draw(hint);
-    }
-    win.display();
-}
+// How a bot search runs. With fuelUse set the bots drive on an unlimited tank
+// and the finishing attempt's fuel use (m) up to every FUEL_COST_STEP_M mark
+// is written there; the rules are otherwise unchanged.
+static const float FUEL_COST_STEP_M = 5.0f;
 
-void drawLevelCompleteMenu(sf::RenderWindow& win, Game& G) {
-    win.clear(sf::Color::White);
+struct BotSearch {
+    int beam = VALIDATOR_BEAM;
+    int windowSteps = VALIDATOR_WINDOW_STEPS;
+    std::vector<float>* fuelUse = nullptr;
+};
 
-    if (G.hasFont) {
-        sf::Text t("Level Complete!", G.font, 48);
-        t.setFillColor(sf::Color::Black);
-        t.setPosition((WINDOW_W - t.getLocalBounds().width) / 2, 80);
-        win.draw(t);
-
-        char buf[256];
-        std::snprintf(buf, sizeof(buf),
-            "Level %d\nDistance: %.1fm\nCoins: %d",
-            G.currentLevel + 1, G.levelDistance_m, G.coinsCollected);
-        sf::Text s(buf, G.font, 28);
-        s.setFillColor(sf::Color::Black);
-        s.setPosition((WINDOW_W - s.getLocalBounds().width) / 2, 160);
-        win.draw(s);
-
-        sf::Vector2i mousePos = sf::Mouse::getPosition(win);
-        sf::Color arrowNormal = sf::Color::Black;
-        sf::Color arrowHover = sf::Color::Red;
-        sf::Color buttonNormal = sf::Color(0, 120, 255);
-        sf::Color buttonHover = sf::Color(0, 80, 200);
-        sf::Color buttonTextColor = sf::Color::White;
-
-        // Draw left arrow
-        sf::Text leftArrow(sf::String(static_cast<sf::Uint32>(0x2190)), G.font, 60);
-        leftArrow.setFillColor(leftArrow.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? arrowHover : arrowNormal);
-        leftArrow.setPosition(300, 350);
-        win.draw(leftArrow);
-
-        // Draw right arrow
-        sf::Text rightArrow(sf::String(static_cast<sf::Uint32>(0x2192)), G.font, 60);
-        rightArrow.setFillColor(rightArrow.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? arrowHover : arrowNormal);
-        rightArrow.setPosition(900, 350);
-        win.draw(rightArrow);
-
-        // Draw retry button (middle)
-        sf::RectangleShape retryButton(sf::Vector2f(200.0f, 50.0f));
-        retryButton.setPosition(540.0f, 350.0f);
-        retryButton.setFillColor(retryButton.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? buttonHover : buttonNormal);
-        retryButton.setOutlineColor(sf::Color::Black);
-        retryButton.setOutlineThickness(2.0f);
-        win.draw(retryButton);
-
-        sf::Text retryText("Retry", G.font, 24);
-        retryText.setFillColor(buttonTextColor);
-        sf::FloatRect textBounds = retryText.getLocalBounds();
-        retryText.setPosition(
-            540.0f + (200.0f - textBounds.width) / 2,
-            350.0f + (50.0f - textBounds.height) / 2 - textBounds.top
-        );
-        win.draw(retryText);
-
-        // Draw exit button (lower)
-        sf::RectangleShape exitButton(sf::Vector2f(200.0f, 50.0f));
-        exitButton.setPosition(540.0f, 500.0f);
-        exitButton.setFillColor(exitButton.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? buttonHover : buttonNormal);
-        exitButton.setOutlineColor(sf::Color::Black);
-        exitButton.setOutlineThickness(2.0f);
-        win.draw(exitButton);
-
-        sf::Text exitText("Exit", G.font, 24);
-        exitText.setFillColor(buttonTextColor);
-        textBounds = exitText.getLocalBounds();
-        exitText.setPosition(
-            540.0f + (200.0f - textBounds.width) / 2,
-            500.0f + (50.0f - textBounds.height) / 2 - textBounds.top
-        );
-        win.draw(exitText);
-
-        // Hint
-        sf::Text hint("Left/Right: Change Level   R: Restart   Backspace: Main Menu", G.font, 22);
-        hint.setFillColor(sf::Color::Black);
-        hint.setPosition((WINDOW_W - hint.getLocalBounds().width) / 2, 620);
-        win.draw(hint);
-    }
-    win.display();
-}
+LevelVerdict validateLevel(Level& level, const BotSearch& search) {
+    struct Attempt { RunState run; std::vector<char> cansTaken; std::vector<float> fuelAt; int marks = 0; float score = 0.0f; };
+    enum Control { Throttle, Coast, Reverse };
 
-void drawGameCompletedMenu(sf::RenderWindow& win, Game& G) {
-    win.clear(sf::Color::White);
+    LevelVerdict v;
+    std::vector<int> deaths(static_cast<size_t>(level.length_m / VALIDATOR_SEGMENT_M) + 2, 0);
+    for (Coin& c : level.coins) c.taken = true; // coins do not decide completion; skip their checks
 
-    if (G.hasFont) {
-        sf::Text t("Game Completed!", G.font, 48);
-        t.setFillColor(sf::Color::Black);
-        t.setPosition((WINDOW_W - t.getLocalBounds().width) / 2, 80);
-        win.draw(t);
-
-        char buf[256];
-        std::snprintf(buf, sizeof(buf),
-            "Total Distance: %.1fm\nTotal Coins: %d",
-            G.totalDistance_m, G.totalCoins);
-        sf::Text s(buf, G.font, 28);
-        s.setFillColor(sf::Color::Black);
-        s.setPosition((WINDOW_W - s.getLocalBounds().width) / 2, 160);
-        win.draw(s);
-
-        sf::Vector2i mousePos = sf::Mouse::getPosition(win);
-        sf::Color buttonNormal = sf::Color(0, 120, 255);
-        sf::Color buttonHover = sf::Color(0, 80, 200);
-        sf::Color buttonTextColor = sf::Color::White;
-
-        // Draw exit button (centered)
-        sf::RectangleShape exitButton(sf::Vector2f(200.0f, 50.0f));
-        exitButton.setPosition((WINDOW_W - 200.0f) / 2, 350.0f);
-        exitButton.setFillColor(exitButton.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos)) ? buttonHover : buttonNormal);
-        exitButton.setOutlineColor(sf::Color::Black);
-        exitButton.setOutlineThickness(2.0f);
-        win.draw(exitButton);
-
-        sf::Text exitText("Exit", G.font, 24);
-        exitText.setFillColor(buttonTextColor);
-        sf::FloatRect textBounds = exitText.getLocalBounds();
-        exitText.setPosition(
-            (WINDOW_W - 200.0f) / 2 + (200.0f - textBounds.width) / 2,
-            350.0f + (50.0f - textBounds.height) / 2 - textBounds.top
-        );
-        win.draw(exitText);
-
-        // Hint
-        sf::Text hint("Backspace: Main Menu", G.font, 22);
-        hint.setFillColor(sf::Color::Black);
-        hint.setPosition((WINDOW_W - hint.getLocalBounds().width) / 2, 620);
-        win.draw(hint);
-    }
-    win.display();
+    Attempt start;
+    start.run.startRun(level);
+    start.cansTaken.assign(level.cans.size(), 0);
+    if (search.fuelUse) {
+        start.run.fuel_m = 1e30f;
+        start.fuelAt.assign(static_cast<size_t>(std::ceil(level.length_m / FUEL_COST_STEP_M)) + 1, 0.0f);
+    }
+    std::vector<Attempt> beam{ start }, children;
+    const int windows = static_cast<int>((level.length_m / VALIDATOR_MIN_SPEED_MPS + 60.0f) / (search.windowSteps * DT_FIXED));
+
+    for (int w = 0; w < windows && !beam.empty() && !v.completable; w++) {
+        children.clear();
+        for (const Attempt& parent : beam) {
+            for (int control = Throttle; control <= Reverse && !v.completable; control++) {
+                Attempt a = parent;
+                a.run.car.pressingRight = control == Throttle;
+                a.run.car.pressingLeft = control == Reverse;
+                for (size_t i = 0; i < level.cans.size(); i++) level.cans[i].taken = a.cansTaken[i] != 0;
+
+                RunOutcome outcome = RunOutcome::Running;
+                for (int s = 0; s < search.windowSteps && outcome == RunOutcome::Running; s++) {
+                    outcome = stepRun(a.run, level, DT_FIXED, nullptr);
+                    v.steps++;
+                    while (a.marks < static_cast<int>(a.fuelAt.size()) && a.run.car.x_px >= m2px(a.marks * FUEL_COST_STEP_M))
+                        a.fuelAt[a.marks++] = a.run.levelDistance_m;
+                }
+                v.best_m = std::max(v.best_m, px2m(std::min(a.run.car.x_px, level.finishX_px)));
+                if (outcome == RunOutcome::Finished) {
+                    v.completable = true;
+                    if (search.fuelUse) {
+                        for (; a.marks < static_cast<int>(a.fuelAt.size()); a.marks++) a.fuelAt[a.marks] = a.run.levelDistance_m;
+                        *search.fuelUse = a.fuelAt;
+                    }
+                    break;
+                }
+                if (outcome != RunOutcome::Running) {
+                    (outcome == RunOutcome::Crashed ? v.crashes : v.fuelOuts)++;
+                    int seg = std::clamp(static_cast<int>(px2m(a.run.car.x_px) / VALIDATOR_SEGMENT_M), 0, static_cast<int>(deaths.size()) - 1);
+                    deaths[seg]++;
+                    continue;
+                }
+                for (size_t i = 0; i < level.cans.size(); i++) a.cansTaken[i] = level.cans[i].taken;
+                a.score = a.run.car.x_px + (search.fuelUse ? 0.0f : m2px(a.run.fuel_m)); // furthest it could get without another can
+                children.push_back(std::move(a));
+            }
+        }
+
+        // Keep the best attempts, dropping near-duplicates so the beam stays diverse
+        std::sort(children.begin(), children.end(), [](const Attempt& a, const Attempt& b) { return a.score > b.score; });
+        beam.clear();
+        for (Attempt& c : children) {
+            if (static_cast<int>(beam.size()) == search.beam) break;
+            bool duplicate = false;
+            for (const Attempt& kept : beam) {
+                const Vehicle& p = kept.run.car;
+                const Vehicle& q = c.run.car;
+                if (std::fabs(p.x_px - q.x_px) < 4.0f && std::fabs(p.vx - q.vx) < 20.0f && std::fabs(p.angle - q.angle) < 0.1f) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (!duplicate) beam.push_back(std::move(c));
+        }
+    }
+
+    for (size_t i = 0; i < deaths.size(); i++) {
+        if (deaths[i] > v.hardestDeaths) {
+            v.hardestDeaths = deaths[i];
+            v.hardestSegment = static_cast<int>(i);
+        }
+    }
+    return v;
 }
 
-// ---------------------------- Main ------------------------------------
-int main() {
-    sf::RenderWindow window(sf::VideoMode(WINDOW_W, WINDOW_H), "Black And White Racing");
-    window.setFramerateLimit(120);
+// Level validation: --validate-levels [count|designed] [first seed]
+// Validates the five designed levels, or count generated ones from first
+// seed, and writes one CSV row per level.
+int runLevelValidator(int count, sf::Uint32 firstSeed, const std::string& tuningPath) {
+    readTuningFile(tuningPath, g_tuning); // validate against the rules and cans the game will load
+    readLevelBake(LEVEL_BAKE_FILE, g_levelBake);
+    bool designed = count <= 0;
+    if (designed) count = 5;
+
+    struct Row { LevelVerdict verdict; float length_m; double ms; };
+    std::vector<Row> rows(count);
+    std::atomic<int> next{ 0 };
+    sf::Clock timer;
+
+    auto worker = [&] {
+        Level level;
+        for (int i = next++; i < count; i = next++) {
+            sf::Clock levelTimer;
+            if (designed) buildLevelData(level, i);
+            else generateLevelData(level, firstSeed + static_cast<sf::Uint32>(i));
+            LevelVerdict v = validateLevel(level, BotSearch());
+            if (!v.completable) {
+                long long narrowSteps = v.steps;
+                BotSearch wide;
+                wide.beam = VALIDATOR_BEAM * 4;
+                v = validateLevel(level, wide);
+                v.steps += narrowSteps;
+            }
+            rows[i].verdict = v;
+            rows[i].length_m = level.length_m;
+            rows[i].ms = levelTimer.getElapsedTime().asMicroseconds() / 1000.0;
+        }
+    };
+    unsigned threads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), count));
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+    double wall_s = timer.getElapsedTime().asSeconds();
+
+    FILE* csv = std::fopen(VALIDATED_LEVELS_CSV, "w");
+    if (csv) std::fprintf(csv, "level,completable,best_m,length_m,hardest_from_m,hardest_deaths,crashes,fuel_outs,steps,ms\n");
+    int completable = 0;
+    for (int i = 0; i < count; i++) {
+        const LevelVerdict& v = rows[i].verdict;
+        completable += v.completable;
+        char name[32];
+        if (designed) std::snprintf(name, sizeof(name), "level %d", i + 1);
+        else std::snprintf(name, sizeof(name), "seed %u", firstSeed + static_cast<sf::Uint32>(i));
+        float hardest_m = v.hardestSegment * VALIDATOR_SEGMENT_M;
+        if (csv)
+            std::fprintf(csv, "%s,%d,%.1f,%.0f,%.0f,%d,%d,%d,%lld,%.1f\n", name, v.completable ? 1 : 0, v.best_m,
+                rows[i].length_m, v.hardestSegment >= 0 ? hardest_m : -1.0f, v.hardestDeaths, v.crashes, v.fuelOuts, v.steps, rows[i].ms);
+        if (designed || !v.completable) {
+            std::cout << std::fixed << std::setprecision(0) << "  " << name << ": " << (v.completable ? "completable" : "NOT completable")
+                      << ", best " << v.best_m << " / " << rows[i].length_m << " m";
+            if (v.hardestSegment >= 0)
+                std::cout << ", hardest " << hardest_m << "-" << hardest_m + VALIDATOR_SEGMENT_M << " m (" << v.hardestDeaths << " bots lost)";
+            std::cout << std::endl;
+        }
+    }
+    if (csv) std::fclose(csv);
 
-    Game G;
-    G.setupFont();
+    std::cout << std::fixed << std::setprecision(1) << "Validated " << count << " levels (tank " << g_tuning.fuelTankMeters
+              << " m, cans every " << g_tuning.fuelCanGapMeters << " m) in " << wall_s << " s on " << threads
+              << " threads: " << completable << " completable -> " << VALIDATED_LEVELS_CSV << std::endl;
+    return completable == count ? 0 : 1;
+}
 
-    // Initial level
-    G.buildLevel(0);
+// Fuel can baking: --bake-levels [target]
+// Places each designed level's cans by dynamic programming over measured fuel
+// cost. Bots drive the level on an unlimited tank in three driving styles
+// (controls held 1/6, 1/4 or 3/8 s); the most fuel any style burned on each
+// FUEL_COST_STEP_M stretch, stalls and roll-backs included, is its cost. Cans
+// then go where every leg between refills burns as close to target x tank as
+// possible and never more than FUEL_BAKE_MAX_USE x tank. Each placement is
+// checked with the normal bot search before levels.bake is written.
+static const int   FUEL_BAKE_WINDOWS[] = { 20, 30, 45 };
+static const float FUEL_BAKE_MAX_USE = 0.9f;      // hardest allowed leg, share of the tank
+static const float FUEL_BAKE_CAN_FROM_M = 10.0f;  // no can on the start line
+
+int runLevelBake(float target, const std::string& tuningPath) {
+    readTuningFile(tuningPath, g_tuning); // cans are placed for the rules the game will load
+    const float tank = g_tuning.fuelTankMeters;
+    target = std::clamp(target, 0.1f, FUEL_BAKE_MAX_USE);
+
+    struct Result { bool measured = false, placed = false; float worstLeg = 0.0f; LevelVerdict check; };
+    Result results[5];
+    LevelBake bake;
+    readLevelBake(LEVEL_BAKE_FILE, bake); // keeps baked coins measured under this tuning
+    if (!bake.fitsTuning()) {
+        bool dropped = false;
+        for (auto& coins : bake.coins) {
+            dropped = dropped || !coins.empty();
+            coins.clear();
+        }
+        if (dropped) std::cout << "Dropped baked coins measured under another tuning; rerun --bake-coins" << std::endl;
+    }
+    bake.tuning = tuningHash(g_tuning);
+    for (auto& cans : bake.cans_m) cans.clear();
+    std::atomic<int> next{ 0 };
+    sf::Clock timer;
+
+    auto worker = [&] {
+        Level level;
+        std::vector<float> use, stretch, cum;
+        for (int i = next++; i < 5; i = next++) {
+            Result& r = results[i];
+            buildLevelData(level, i);
+            level.cans.clear();
+
+            // Worst fuel use per stretch over the driving styles that finish
+            stretch.clear();
+            for (int window : FUEL_BAKE_WINDOWS) {
+                BotSearch search;
+                search.windowSteps = window;
+                search.fuelUse = &use;
+                if (!validateLevel(level, search).completable) continue;
+                stretch.resize(use.size(), 0.0f);
+                for (size_t k = 1; k < use.size(); k++) stretch[k] = std::max(stretch[k], use[k] - use[k - 1]);
+                r.measured = true;
+            }
+            if (!r.measured) continue;
+            cum.assign(stretch.size(), 0.0f);
+            for (size_t k = 1; k < stretch.size(); k++) cum[k] = cum[k - 1] + stretch[k];
+
+            // best[b]: lowest penalty with a refill at mark b (0 = start, n = finish)
+            const int n = static_cast<int>(cum.size()) - 1;
+            const int first = static_cast<int>(std::ceil(FUEL_BAKE_CAN_FROM_M / FUEL_COST_STEP_M));
+            std::vector<float> best(n + 1, 1e30f);
+            std::vector<int> prev(n + 1, -1);
+            best[0] = 0.0f;
+            for (int b = first; b <= n; b++) {
+                for (int a = b - 1; a >= 0; a--) {
+                    if (a > 0 && a < first) continue;
+                    float leg = (cum[b] - cum[a]) / tank;
+                    if (leg > FUEL_BAKE_MAX_USE) break; // only grows further back
+                    if (best[a] >= 1e30f) continue;
+                    float miss = (b == n) ? std::max(0.0f, leg - target) : leg - target; // a short last leg is fine
+                    if (best[a] + miss * miss < best[b]) {
+                        best[b] = best[a] + miss * miss;
+                        prev[b] = a;
+                    }
+                }
+            }
+            if (prev[n] < 0) continue; // some stretch alone burns more than the cap allows
 
-    sf::Clock clock;
-    float accumulator = 0.0f;
+            std::vector<float>& cans = bake.cans_m[i];
+            for (int b = n; b > 0; b = prev[b]) {
+                r.worstLeg = std::max(r.worstLeg, (cum[b] - cum[prev[b]]) / tank);
+                if (b < n) cans.push_back(b * FUEL_COST_STEP_M);
+            }
+            std::reverse(cans.begin(), cans.end());
+            r.placed = true;
 
-    // Camera view
-    sf::View view(sf::FloatRect(0, 0, WINDOW_W, WINDOW_H));
+            // The placement has to hold up under the real rules
+            for (float x_m : cans) level.cans.push_back({ m2px(x_m), false });
+            r.check = validateLevel(level, BotSearch());
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < std::max(1u, std::min(std::thread::hardware_concurrency(), 5u)); t++) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+
+    bool ok = true;
+    for (int i = 0; i < 5; i++) {
+        const Result& r = results[i];
+        std::cout << "  level " << (i + 1) << ": ";
+        if (!r.placed) {
+            std::cout << (r.measured ? "no placement keeps every leg under the cap" : "no bot finished on an unlimited tank")
+                      << "; keeps the fixed gap" << std::endl;
+            ok = false;
+            continue;
+        }
+        std::cout << bake.cans_m[i].size() << " cans, hardest leg " << std::fixed << std::setprecision(0)
+                  << r.worstLeg * 100.0f << "% of the tank, " << (r.check.completable ? "completable" : "NOT completable") << std::endl;
+        ok = ok && r.check.completable;
+    }
+    if (!writeLevelBake(LEVEL_BAKE_FILE, bake)) {
+        std::cout << "Cannot write " << LEVEL_BAKE_FILE << std::endl;
+        return 1;
+    }
+    std::cout << std::fixed << std::setprecision(1) << "Baked cans for a " << tank << " m tank at " << target * 100.0f
+              << "% per leg in " << timer.getElapsedTime().asSeconds() << " s -> " << LEVEL_BAKE_FILE << std::endl;
+    return ok ? 0 : 1;
+}
 
-    while (window.isOpen()) {
-        // ---------------- Events ----------------
-        sf::Event ev;
-        while (window.pollEvent(ev)) {
-            if (ev.type == sf::Event::Closed)
-                window.close();
+// Coin baking: --bake-coins [runs] [ridge|risky]
+// Places each designed level's coins on the envelope of simulated runs. The
+// threads drive `runs` randomized bots through stepRun, with the level's real
+// cans, and count where the chassis centre (Vehicle::y_px) is every step in
+// their own density grid: 1 m columns by COIN_GRID_ROW_M rows of height above
+// the ground, so a baked hover is the chassis centre's height. The grids
+// are only summed after the threads are joined, so accumulation shares
+// nothing. The level is cut into COINS_PER_LEVEL sections with one coin each:
+// on the densest cell (ridge: where most runs pass), or on the highest cell
+// at least COIN_RISKY_SHARE as busy as that (risky: reached in the air, not
+// by everyone). The coins are merged into levels.bake next to the cans.
+static const float COIN_GRID_ROW_M = 0.5f;
+static const int   COIN_GRID_ROWS = 80;       // up to 40 m above the ground
+static const float COIN_RISKY_SHARE = 0.05f;
+static const float COIN_FROM_M = 15.0f;       // the first section starts past the spawn
+static const float COIN_MIN_GAP_M = 6.0f;     // neighbouring sections never put coins closer
+static const int   COIN_CHECK_RUNS = 400;     // fresh runs comparing the old and new coins
+
+// One randomized bot run from the start line; visit(run) sees every step.
+// Every seed is a different driver: how far it lets the car tilt against the
+// slope before correcting, how often it throttles, how long it holds a choice.
+template <typename Visit>
+void driveRandomRun(Level& level, sf::Uint32 seed, Visit&& visit) {
+    FxRandom rng;
+    rng.state = (seed + 1u) * 2654435761u | 1u;
+    const float tilt = rng.range(0.2f, 0.9f), throttle = rng.range(0.5f, 0.95f);
+    RunState run;
+    run.startRun(level);
+    for (FuelCan& c : level.cans) c.taken = false;
+
+    const int maxSteps = static_cast<int>((level.length_m / VALIDATOR_MIN_SPEED_MPS + 60.0f) / DT_FIXED);
+    int hold = 0;
+    for (int s = 0; s < maxSteps; s++) {
+        if (--hold <= 0) {
+            Vehicle& car = run.car;
+            float rel = car.angle - std::atan(sampleGround(car.x_px, level).slope);
+            if (std::fabs(rel) > tilt) { // right turns the car clockwise, left back
+                car.pressingRight = rel > 0.0f;
+                car.pressingLeft = rel < 0.0f;
+                hold = 6;
+            }
+            else {
+                car.pressingRight = rng.next01() < throttle;
+                car.pressingLeft = !car.pressingRight && rng.next01() < 0.2f;
+                hold = static_cast<int>(rng.range(6.0f, 40.0f));
+            }
+        }
+        RunOutcome outcome = stepRun(run, level, DT_FIXED, nullptr);
+        visit(run);
+        if (outcome != RunOutcome::Running) break;
+    }
+}
 
-            if (ev.type == sf::Event::MouseButtonPressed) {
-                if (ev.mouseButton.button == sf::Mouse::Left) {
-                    sf::Vector2f mousePos(ev.mouseButton.x, ev.mouseButton.y);
-                    if (G.screen == Screen::Menu) {
-                        if (G.hasFont) {
-                            if (G.playButton.rect.getGlobalBounds().contains(mousePos)) {
-                                G.screen = Screen::Playing;
-                                G.resetGame();
-                            }
-                            else if (G.exitButton.rect.getGlobalBounds().contains(mousePos)) {
-                                G.screen = Screen::Exit;
-                                window.close();
-                            }
-                        }
-                        else {
-                            // Fallback: click top half for play, bottom half for exit
-                            if (ev.mouseButton.y < WINDOW_H / 2) {
-                                G.screen = Screen::Playing;
-                                G.resetGame();
-                            }
-                            else {
-                                G.screen = Screen::Exit;
-                                window.close();
-                            }
-                        }
-                    }
-                    else if (G.screen == Screen::LevelComplete && G.hasFont) {
-                        sf::Text leftArrow(sf::String(static_cast<sf::Uint32>(0x2190)), G.font, 60); // ←
-                        leftArrow.setPosition(300, 350);
-                        if (leftArrow.getGlobalBounds().contains(mousePos)) {
-                            // Previous level
-                            int prev = std::max(G.currentLevel - 1, 0);
-                            G.buildLevel(prev);
-                            G.screen = Screen::Playing;
-                        }
-                        sf::RectangleShape retryButton(sf::Vector2f(200.0f, 50.0f));
-                        retryButton.setPosition(540, 350);
-                        if (retryButton.getGlobalBounds().contains(mousePos)) {
-                            // Restart current level
-                            G.buildLevel(G.currentLevel);
-                            G.screen = Screen::Playing;
-                        }
-                        sf::Text rightArrow(sf::String(static_cast<sf::Uint32>(0x2192)), G.font, 60); // →
-                        rightArrow.setPosition(900, 350);
-                        if (rightArrow.getGlobalBounds().contains(mousePos)) {
-                            // Next level
-                            int next = std::min(G.currentLevel + 1, 4);
-                            if (next < G.unlockedLevels) {
-                                G.buildLevel(next);
-                                G.screen = Screen::Playing;
-                            }
-                        }
-                        sf::RectangleShape exitButton(sf::Vector2f(200.0f, 50.0f));
-                        exitButton.setPosition(540, 500);
-                        if (exitButton.getGlobalBounds().contains(mousePos)) {
-                            // Return to main menu
-                            G.screen = Screen::Menu;
-                        }
+int runCoinBake(int runs, bool risky, const std::string& tuningPath) {
+    readTuningFile(tuningPath, g_tuning);
+    readLevelBake(LEVEL_BAKE_FILE, g_levelBake); // bots drive past the cans the game will place
+    LevelBake bake = g_levelBake;
+    if (!bake.fitsTuning())
+        for (auto& cans : bake.cans_m) cans.clear(); // measured under other rules; the game lays fixed cans
+    bake.tuning = tuningHash(g_tuning);
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    sf::Clock timer;
+
+    for (int i = 0; i < 5; i++) {
+        Level probe;
+        buildLevelData(probe, i);
+        const int cols = static_cast<int>(std::ceil(probe.length_m)) + 1;
+
+        // Per-thread density grids, summed after the join
+        std::vector<std::vector<sf::Uint32>> grids(threads);
+        std::atomic<int> next{ 0 };
+        std::atomic<long long> finished{ 0 };
+        auto accumulate = [&](unsigned t) {
+            Level level;
+            buildLevelData(level, i);
+            for (Coin& c : level.coins) c.taken = true; // coins are what is being placed
+            std::vector<sf::Uint32>& grid = grids[t];
+            grid.assign(static_cast<size_t>(cols) * COIN_GRID_ROWS, 0);
+            for (int r = next++; r < runs; r = next++) {
+                bool done = false;
+                driveRandomRun(level, static_cast<sf::Uint32>(r), [&](const RunState& run) {
+                    float x_m = px2m(run.car.x_px);
+                    if (x_m < 0.0f || x_m >= cols) return;
+                    float above_m = px2m(sampleGround(run.car.x_px, level).y - run.car.y_px);
+                    int row = std::clamp(static_cast<int>(above_m / COIN_GRID_ROW_M), 0, COIN_GRID_ROWS - 1);
+                    grid[static_cast<size_t>(x_m) * COIN_GRID_ROWS + row]++;
+                    done = run.car.x_px >= level.finishX_px;
+                });
+                if (done) finished++;
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; t++) pool.emplace_back(accumulate, t);
+        for (auto& t : pool) t.join();
+        std::vector<sf::Uint64> density(static_cast<size_t>(cols) * COIN_GRID_ROWS, 0);
+        for (const auto& grid : grids)
+            for (size_t k = 0; k < grid.size(); k++) density[k] += grid[k];
+
+        // One coin per section
+        std::vector<LevelBake::BakedCoin>& coins = bake.coins[i];
+        coins.clear();
+        const float from = COIN_FROM_M, span = probe.length_m - 5.0f - from;
+        int unreached = 0;
+        for (int k = 0; k < COINS_PER_LEVEL; k++) {
+            int c1 = static_cast<int>(from + span * (k + 1) / COINS_PER_LEVEL);
+            int c0 = std::min(c1 - 1, std::max(static_cast<int>(from + span * k / COINS_PER_LEVEL),
+                                               coins.empty() ? 0 : static_cast<int>(coins.back().x_m + COIN_MIN_GAP_M)));
+            sf::Uint64 peak = 0;
+            int bestCol = (c0 + c1) / 2, bestRow = -1;
+            for (int c = c0; c < c1; c++)
+                for (int row = 0; row < COIN_GRID_ROWS; row++)
+                    if (density[static_cast<size_t>(c) * COIN_GRID_ROWS + row] > peak) {
+                        peak = density[static_cast<size_t>(c) * COIN_GRID_ROWS + row];
+                        bestCol = c;
+                        bestRow = row;
                     }
-                    else if (G.screen == Screen::GameOver && G.hasFont) {
-                        sf::Text leftArrow(sf::String(static_cast<sf::Uint32>(0x2190)), G.font, 60); // ←
-                        leftArrow.setPosition(300, 350);
-                        if (leftArrow.getGlobalBounds().contains(mousePos)) {
-                            // Previous level
-                            int prev = std::max(G.currentLevel - 1, 0);
-                            G.buildLevel(prev);
-                            G.screen = Screen::Playing;
-                        }
-                        sf::RectangleShape retryButton(sf::Vector2f(200.0f, 50.0f));
-                        retryButton.setPosition(540, 350);
-                        if (retryButton.getGlobalBounds().contains(mousePos)) {
-                            // Restart current level
-                            G.buildLevel(G.currentLevel);
-                            G.screen = Screen::Playing;
-                        }
-                        sf::Text rightArrow(sf::String(static_cast<sf::Uint32>(0x2192)), G.font, 60); // →
-                        rightArrow.setPosition(900, 350);
-                        if (rightArrow.getGlobalBounds().contains(mousePos)) {
-                            // Next level
-                            int next = std::min(G.currentLevel + 1, 4);
-                            if (next < G.unlockedLevels) {
-                                G.buildLevel(next);
-                                G.screen = Screen::Playing;
-                            }
-                        }
-                        sf::RectangleShape exitButton(sf::Vector2f(200.0f, 50.0f));
-                        exitButton.setPosition(540, 500);
-                        if (exitButton.getGlobalBounds().contains(mousePos)) {
-                            // Return to main menu
-                            G.screen = Screen::Menu;
-                        }
+            if (risky && peak > 0) {
+                // Highest row still busy enough, at its busiest column
+                sf::Uint64 floor = std::max<sf::Uint64>(1, static_cast<sf::Uint64>(peak * COIN_RISKY_SHARE));
+                for (int row = COIN_GRID_ROWS - 1; row > bestRow; row--) {
+                    sf::Uint64 busiest = 0;
+                    int col = -1;
+                    for (int c = c0; c < c1; c++) {
+                        sf::Uint64 d = density[static_cast<size_t>(c) * COIN_GRID_ROWS + row];
+                        if (d >= floor && d > busiest) { busiest = d; col = c; }
                     }
-                    else if (G.screen == Screen::GameCompleted && G.hasFont) {
-                        sf::RectangleShape exitButton(sf::Vector2f(200.0f, 50.0f));
-                        exitButton.setPosition((WINDOW_W - 200.0f) / 2, 350.0f);
-                        if (exitButton.getGlobalBounds().contains(mousePos)) {
-                            // Return to main menu
-                            G.screen = Screen::Menu;
-                        }
+                    if (col >= 0) {
+                        bestRow = row;
+                        bestCol = col;
+                        break;
                     }
                 }
             }
-            if (ev.type == sf::Event::KeyPressed) {
-                if (G.screen == Screen::Menu) {
-                    if (ev.key.code == sf::Keyboard::Num1) {
-                        G.currentLevel = 0; // Start from level 0
-                        G.resetGame();
-                        G.screen = Screen::Playing;
-                    }
-                    else if (ev.key.code == sf::Keyboard::Num0) {
-                        G.screen = Screen::Exit;
-                        window.close();
-                    }
+            if (bestRow < 0) {
+                unreached++;
+                coins.push_back({ bestCol + 0.5f, px2m(50.0f) }); // no run got here; keep the old hover
+            }
+            else {
+                coins.push_back({ bestCol + 0.5f, (bestRow + 0.5f) * COIN_GRID_ROW_M });
+            }
+        }
+
+        // Coins per run with the evenly spaced layout and with the baked one, on unseen drivers
+        auto coinsPerRun = [&](bool baked) {
+            std::atomic<int> nextCheck{ 0 };
+            std::atomic<long long> collected{ 0 };
+            auto check = [&] {
+                Level level;
+                buildLevelData(level, i);
+                if (baked) {
+                    level.coins.clear();
+                    for (const LevelBake::BakedCoin& c : coins) level.coins.push_back({ m2px(c.x_m), 0.0f, false, m2px(c.hover_m) });
+                    settleCoins(level);
                 }
-                else if (G.screen == Screen::Playing) {
-                    if (ev.key.code == sf::Keyboard::Right || ev.key.code == sf::Keyboard::D)
-                        G.car.pressingRight = true;
-                    if (ev.key.code == sf::Keyboard::Left || ev.key.code == sf::Keyboard::A)
-                        G.car.pressingLeft = true;
+                else {
+                    float gap_px = level.length_px / (COINS_PER_LEVEL + 1);
+                    for (int k = 0; k < static_cast<int>(level.coins.size()); k++) level.coins[k] = { (k + 1) * gap_px, 0.0f, false };
+                    settleCoins(level);
                 }
-
-                // Screen-specific key actions for GameOver and LevelComplete
-                if (G.screen == Screen::GameOver || G.screen == Screen::LevelComplete) {
-                    if (ev.key.code == sf::Keyboard::Left) {
-                        int prev = std::max(G.currentLevel - 1, 0);
-                        G.currentLevel = prev;
-                        G.buildLevel(prev);
-                        G.screen = Screen::Playing;
-                    }
-                    else if (ev.key.code == sf::Keyboard::Right) {
-                        int next = std::min(G.currentLevel + 1, 4);
-                        if (next < G.unlockedLevels) {
-                            G.currentLevel = next;
-                            G.buildLevel(next);
-                            G.screen = Screen::Playing;
-                        }
-                    }
-                    else if (ev.key.code == sf::Keyboard::R) {
-                        // Restart current level — ensure currentLevel is preserved
-                        G.buildLevel(G.currentLevel);
-                        G.screen = Screen::Playing;
-                    }
+                for (int r = nextCheck++; r < COIN_CHECK_RUNS; r = nextCheck++) {
+                    for (Coin& c : level.coins) c.taken = false;
+                    int got = 0;
+                    driveRandomRun(level, static_cast<sf::Uint32>(runs + r), [&](const RunState& run) { got = run.coinsCollected; });
+                    collected += got;
                 }
+            };
+            std::vector<std::thread> checkers;
+            for (unsigned t = 0; t < threads; t++) checkers.emplace_back(check);
+            for (auto& t : checkers) t.join();
+            return static_cast<double>(collected.load()) / COIN_CHECK_RUNS;
+        };
+        double before = coinsPerRun(false), after = coinsPerRun(true);
 
-                // Global backspace action
-                if (ev.key.code == sf::Keyboard::BackSpace) {
-                    G.screen = Screen::Menu;
-                }
-            }
+        std::cout << std::fixed << std::setprecision(1) << "  level " << (i + 1) << ": " << runs << " runs ("
+                  << 100.0 * finished.load() / runs << "% finished), coins per run " << before << " -> " << after;
+        if (unreached > 0) std::cout << ", " << unreached << " sections no run reached";
+        std::cout << std::endl;
+    }
+
+    if (!writeLevelBake(LEVEL_BAKE_FILE, bake)) {
+        std::cout << "Cannot write " << LEVEL_BAKE_FILE << std::endl;
+        return 1;
+    }
+    std::cout << std::fixed << std::setprecision(1) << "Baked " << (risky ? "risky" : "ridge") << " coins in "
+              << timer.getElapsedTime().asSeconds() << " s on " << threads << " threads -> " << LEVEL_BAKE_FILE << std::endl;
+    return 0;
+}
 
+// ---------------------------- Startup ---------------------------------
+// The window opens and the menu starts presenting while independent startup
+// work runs on worker threads:
+//  - font file load, then glyph pre-warm on the worker's own GL context
+//  - overview image decode and atlas painting
+//  - the level 1 prebuild
+//  - the daily challenge level (generation, terrain tiers, background)
+// poll() folds each result in on the main thread as it lands. It then runs
+// the GL setup only playing needs (dynamic resolution target, terrain shader),
+// one phase per frame. Serial mode runs the same phases inline before the
+// first frame, as startup used to; it is the baseline for --bench-startup.
+struct Startup {
+    StartupProfile& profile;
+    bool overlapped = true;
+    std::vector<std::thread> workers;
+    std::atomic<bool> fontDone{ false }, thumbsDone{ false }, atlasDone{ false }, levelDone{ false }, dailyDone{ false };
+    bool fontLoaded = false;
+    sf::Image atlasImage;
+    PreparedLevel level0;
+    DailyLevel daily;
+
+    bool fontApplied = false, thumbsApplied = false, atlasApplied = false, levelApplied = false, dailyApplied = false;
+    bool resolutionApplied = false, shaderApplied = false;
+    bool interactive = false; // menu widgets exist
+    bool done = false;        // every phase applied
+    double done_ms = 0.0;
+    bool reported = false;
+
+    Startup(StartupProfile& p, bool overlap) : profile(p), overlapped(overlap) {}
+    ~Startup() { join(); }
+
+    void join() {
+        for (auto& t : workers) t.join();
+        workers.clear();
+    }
 
-            if (ev.type == sf::Event::KeyReleased && G.screen == Screen::Playing) {
-                if (ev.key.code == sf::Keyboard::Right || ev.key.code == sf::Keyboard::D)
-                    G.car.pressingRight = false;
-                if (ev.key.code == sf::Keyboard::Left || ev.key.code == sf::Keyboard::A)
-                    G.car.pressingLeft = false;
+    void launch(Game& G) {
+        if (!overlapped) return;
+        workers.emplace_back([this, &G] {
+            profile.time("font load", true, [&] { fontLoaded = G.loadFont(); });
+            if (fontLoaded) {
+                profile.time("glyph pre-warm", true, [&] {
+                    sf::Context context; // glyph pages are GL textures
+                    G.prewarmGlyphs();
+                    glFlush();
+                });
             }
-        } // <-- closes while (pollEvent)
+            fontDone = true;
+        });
+        workers.emplace_back([this, &G] {
+            profile.time("overview decode", true, [&] { G.thumbnails.decode(OVERVIEW_DIR); });
+            thumbsDone = true;
+            profile.time("atlas paint", true, [&] { Background::paintAtlas(atlasImage); });
+            atlasDone = true;
+        });
+        workers.emplace_back([this] {
+            profile.time("level 1 prebuild", true, [&] { prepareLevel(level0, 0); });
+            levelDone = true;
+        });
+        workers.emplace_back([this] {
+            profile.time("daily generation", true, [&] { prepareDaily(daily, utcDateToday()); });
+            dailyDone = true;
+        });
+    }
 
-        // ---------------- Screen-specific logic ----------------
-        if (G.screen == Screen::Menu) {
-            drawMenu(window, G);
-            continue;
+    // Main thread, once per frame before drawing
+    void poll(Game& G) {
+        if (done) return;
+        if (!overlapped) {
+            runSerial(G);
         }
-        if (G.screen == Screen::Exit) {
-            break;
+        else {
+            if (!fontApplied && fontDone) {
+                profile.time("ui build", false, [&] { G.setupUi(fontLoaded); });
+                fontApplied = interactive = true;
+            }
+            if (!thumbsApplied && thumbsDone) {
+                profile.time("overview upload", false, [&] { G.thumbnails.upload(); });
+                thumbsApplied = true;
+            }
+            if (!atlasApplied && atlasDone) {
+                profile.time("atlas upload", false, [&] { G.background.uploadAtlas(atlasImage); });
+                atlasImage = sf::Image();
+                atlasApplied = true;
+            }
+            if (!dailyApplied && dailyDone) {
+                G.daily = std::move(daily);
+                dailyApplied = true;
+            }
+            if (!levelApplied && levelDone) {
+                G.prefetcher.adopt(0, level0);
+                levelApplied = true;
+            }
+            else if (interactive && !resolutionApplied) {
+                profile.time("render target", false, [&] { G.resolution.create(); });
+                resolutionApplied = true;
+            }
+            else if (interactive && !shaderApplied) {
+                profile.time("terrain shader", false, [&] { G.useTerrainShader = G.terrainShader.load(); });
+                shaderApplied = true;
+            }
+            if (!(fontApplied && thumbsApplied && atlasApplied && levelApplied && dailyApplied && resolutionApplied && shaderApplied)) return;
+            join();
         }
+        done = true;
+        done_ms = profile.now_ms();
+    }
 
-        // ---------------- Fixed-step update ----------------
-        float dt = clock.restart().asSeconds();
-        accumulator += dt;
-        while (accumulator >= DT_FIXED) {
-            if (G.screen != Screen::Playing)
-                break; // Stop updating if not playing
+    void runSerial(Game& G) {
+        profile.time("render target", false, [&] { G.resolution.create(); });
+        profile.time("overview load", false, [&] { G.thumbnails.load(OVERVIEW_DIR); });
+        profile.time("font load", false, [&] { fontLoaded = G.loadFont(); });
+        if (fontLoaded) profile.time("glyph pre-warm", false, [&] { G.prewarmGlyphs(); });
+        profile.time("ui build", false, [&] { G.setupUi(fontLoaded); });
+        profile.time("terrain shader", false, [&] { G.useTerrainShader = G.terrainShader.load(); });
+        profile.time("atlas", false, [&] { G.background.createAtlas(); });
+        profile.time("level 1 build", false, [&] {
+            prepareLevel(level0, 0);
+            G.prefetcher.adopt(0, level0);
+        });
+        profile.time("daily generation", false, [&] { prepareDaily(G.daily, utcDateToday()); });
+        interactive = true;
+    }
 
-            stepVehicle(G, DT_FIXED);
-            updateFuelAndPickups(G);
+    // Call after presenting a menu frame; the first one with widgets is time-to-interactive
+    void onMenuPresented(bool printReport) {
+        if (interactive && profile.interactive_ms < 0.0) profile.interactive_ms = profile.now_ms();
+        if (printReport && !reported && done && profile.interactive_ms >= 0.0) {
+            profile.report();
+            reported = true;
+        }
+    }
+};
 
-            // Head-ground check
-            if (checkHeadHit(G)) {
-                G.headHitGround = true;
+// Startup benchmark: --bench-startup [runs]
+// Times process-side startup to interactive for serial and overlapped startup,
+// alternating modes so disk caches warm both equally (the first pair is
+// discarded). Exits nonzero if overlapped startup is not faster, so a change
+// that serializes startup again shows up.
+int runStartupBenchmark(int runs) {
+    std::vector<double> tti[2], all[2];
+    for (int r = 0; r < (runs + 1) * 2; r++) {
+        int overlapped = r % 2;
+        StartupProfile profile;
+        double doneAt = 0.0;
+        {
+            Game G;
+            Startup startup(profile, overlapped != 0);
+            startup.launch(G);
+            sf::RenderWindow window;
+            profile.time("window", false, [&] {
+                window.create(sf::VideoMode(WINDOW_W, WINDOW_H), "Black And White Racing (startup benchmark)");
+            });
+            while (!startup.done || profile.interactive_ms < 0.0) {
+                sf::Event ev;
+                while (window.pollEvent(ev)) {}
+                startup.poll(G);
+                drawMenu(window, G);
+                window.display();
+                startup.onMenuPresented(false);
             }
+            doneAt = startup.done_ms;
+        }
+        if (r < 2) continue;
+        tti[overlapped].push_back(profile.interactive_ms);
+        all[overlapped].push_back(doneAt);
+    }
 
-            // Fuel check
-            if (G.fuel_m <= 0.0f) {
-                if (G.fuel_out_timer < 0.0f) {
-                    G.fuel_out_timer = 5.0f;
-                }
-                else {
-                    G.fuel_out_timer -= DT_FIXED;
+    auto median = [](std::vector<double>& v) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    };
+    double serial = median(tti[0]), overlapped = median(tti[1]);
+    std::cout << std::fixed << std::setprecision(1) << "Startup, median of " << runs << " runs:" << std::endl
+              << "  serial      time to interactive " << serial << " ms, all phases " << median(all[0]) << " ms" << std::endl
+              << "  overlapped  time to interactive " << overlapped << " ms, all phases " << median(all[1]) << " ms" << std::endl
+              << "  " << (serial > 0.0 ? 100.0 * (serial - overlapped) / serial : 0.0) << "% faster to interactive" << std::endl;
+    return overlapped < serial ? 0 : 1;
+}
+
+// ---------------------------- Screen loop -----------------------------
+// Each screen is a row of handlers the loop dispatches to. Playing ticks every
+// frame at the pacer rate and runs the fixed-step simulation. The menus and
+// result screens are event driven: they repaint only when an event (or a
+// startup phase still landing, or an active capture) asks for it and idle in
+// between. Every change of G.screen runs exit then enter, and entering Playing
+// restarts the frame clock with an empty accumulator, so time spent on another
+// screen never turns into a backlog of physics steps.
+static const int   SCREEN_IDLE_WAIT_MS = 4;   // event poll interval of an idle menu
+static const float SCREEN_REFRESH_S = 0.5f;   // idle menus still repaint this often
+
+// Single exit point for every finished frame
+void presentFrame(sf::RenderWindow& win, Game& G) {
+    AllocScope scope(AllocPresent);
+    G.latency.onFrameSubmitted();
+    G.capture.onFrame();
+    G.pacer.present(win);
+    G.latency.onFramePresented();
+}
+
+struct ScreenLoop;
+struct ScreenHandlers {
+    bool eventDriven;
+    void (*enter)(ScreenLoop&);
+    void (*exit)(ScreenLoop&);
+    UiAction (*key)(ScreenLoop&, sf::Keyboard::Key); // screen keys, as menu actions
+    void (*update)(ScreenLoop&);
+    void (*render)(ScreenLoop&);
+};
+
+// CPU time used by the calling thread (waits and sleeps excluded)
+sf::Int64 threadCpuUs() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) return 0;
+    auto ticks = [](const FILETIME& t) { return (static_cast<sf::Int64>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) / 10; // 100 ns units
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return static_cast<sf::Int64>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+struct ScreenUsage { sf::Int64 wall_us = 0, cpu_us = 0; unsigned frames = 0; };
+
+struct ScreenLoop {
+    sf::RenderWindow& window;
+    Game& G;
+    Startup& startup;
+    sf::View view{ sf::FloatRect(0, 0, WINDOW_W, WINDOW_H) };
+    sf::Clock clock;
+    float accumulator = 0.0f, dt = 0.0f;
+
+    Screen current = Screen::Menu;
+    bool dirty = true;        // an event-driven screen needs a repaint
+    sf::Clock sinceRepaint;
+
+    ScreenUsage usage[MEM_SCREENS];
+    Screen markScreen = Screen::Menu;
+    sf::Int64 markWall_us = 0, markCpu_us = 0;
+
+    ScreenLoop(sf::RenderWindow& w, Game& g, Startup& s) : window(w), G(g), startup(s) {
+        markWall_us = nowUs();
+        markCpu_us = threadCpuUs();
+    }
+
+    const ScreenHandlers& handlers(Screen s) const;
+
+    // Runs exit/enter until G.screen settles (an enter may move on again)
+    void transition() {
+        while (G.screen != current) {
+            if (auto exit = handlers(current).exit) exit(*this);
+            current = G.screen;
+            dirty = true;
+            if (auto enter = handlers(current).enter) enter(*this);
+        }
+    }
+
+    void globalKey(sf::Keyboard::Key key) {
+        // F5 prints CPU use per screen
+        if (key == sf::Keyboard::F5) printUsage();
+        // F6 toggles per-screen memory peak tracking, F7 prints the memory report
+        if (key == sf::Keyboard::F6) {
+            bool on = !g_memory.trackPeaks.load();
+            if (!on) printMemoryReport(G);
+            setMemoryPeakTracking(on);
+        }
+        if (key == sf::Keyboard::F7)
+            printMemoryReport(G);
+        // F9 starts/stops gameplay capture
+        if (key == sf::Keyboard::F9) {
+            if (G.capture.active) G.capture.stop();
+            else G.capture.start(window);
+        }
+        // Global backspace action
+        if (key == sf::Keyboard::BackSpace)
+            G.screen = Screen::Menu;
+    }
+
+    void handleEvents() {
+        sf::Event ev;
+        while (window.pollEvent(ev)) {
+            dirty = true;
+            if (ev.type == sf::Event::Closed) {
+                G.capture.stop(); // needs the window's GL context
+                window.close();
+            }
+            if (ev.type == sf::Event::MouseButtonPressed && ev.mouseButton.button == sf::Mouse::Left) {
+                if (UiScreen* ui = G.uiFor(G.screen)) {
+                    sf::Vector2f mousePos(static_cast<float>(ev.mouseButton.x), static_cast<float>(ev.mouseButton.y));
+                    applyUiAction(G, ui->actionAt(mousePos));
                 }
             }
-            else {
-                G.fuel_out_timer = -1.0f;
+            if (ev.type == sf::Event::KeyPressed) {
+                if (auto key = handlers(G.screen).key) applyUiAction(G, key(*this, ev.key.code));
+                globalKey(ev.key.code);
             }
+            if (ev.type == sf::Event::LostFocus) G.input.focused = false;
+            if (ev.type == sf::Event::GainedFocus) G.input.focused = true;
+            transition();
+        }
+    }
 
-            // Finish line
-            if (G.car.x_px >= G.level.finishX_px) {
-                G.totalDistance_m += G.levelDistance_m;
-                G.totalCoins += G.coinsCollected;
+    // Charges the time since the last mark to the screen that was showing
+    void account() {
+        sf::Int64 wall = nowUs(), cpu = threadCpuUs();
+        ScreenUsage& u = usage[static_cast<int>(markScreen)];
+        u.wall_us += wall - markWall_us;
+        u.cpu_us += cpu - markCpu_us;
+        markWall_us = wall;
+        markCpu_us = cpu;
+        markScreen = current;
+    }
 
-                int next = G.currentLevel + 1;
-                if (next < 5) {
-                    G.unlockedLevels = std::max(G.unlockedLevels, next + 1);
-                    // Instead of immediately starting next level, show level complete menu
-                    G.screen = Screen::LevelComplete;
-                }
-                else {
-                    // All levels complete -> show final score
-                    G.screen = Screen::GameCompleted;
-                }
-            }
+    void frame() {
+        account();
+        handleEvents();
+        if (!window.isOpen()) return;
+
+        const ScreenHandlers& h = handlers(current);
+        if (h.update) h.update(*this);
+        transition();
+        if (!window.isOpen()) return;
+
+        const ScreenHandlers& shown = handlers(current);
+        bool repaint = !shown.eventDriven || dirty || !startup.done || G.capture.active ||
+                       sinceRepaint.getElapsedTime().asSeconds() >= SCREEN_REFRESH_S;
+        if (!repaint) {
+            sf::sleep(sf::milliseconds(SCREEN_IDLE_WAIT_MS));
+            return;
+        }
+        if (!shown.render) return;
+        shown.render(*this);
+        usage[static_cast<int>(current)].frames++;
+        dirty = false;
+        sinceRepaint.restart();
+    }
 
-            // Fuel timeout or crash -> game over
-            if ((G.fuel_out_timer <= 0.0f && G.fuel_out_timer > -1.0f) || G.headHitGround) {
-                G.totalDistance_m += G.levelDistance_m;
-                G.totalCoins += G.coinsCollected;
-                G.screen = Screen::GameOver;
-            }
+    void printUsage() {
+        account();
+        std::cout << std::fixed << std::setprecision(2) << "CPU by screen (main thread):" << std::endl;
+        for (int s = 0; s < MEM_SCREENS; s++) {
+            const ScreenUsage& u = usage[s];
+            if (u.wall_us == 0) continue;
+            double wall_s = u.wall_us / 1e6;
+            std::cout << "  " << std::setw(15) << MEM_SCREEN_NAMES[s] << std::setw(9) << wall_s << " s  "
+                      << std::setw(7) << u.frames << " frames  " << std::setw(7) << u.frames / wall_s << " fps  cpu "
+                      << std::setw(6) << 100.0 * u.cpu_us / u.wall_us << "%  "
+                      << (u.frames ? u.cpu_us / 1000.0 / u.frames : 0.0) << " ms/frame" << std::endl;
+        }
+    }
+};
+
+UiAction menuKey(ScreenLoop&, sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::Num1) return UiAction::Play;
+    if (key == sf::Keyboard::Num2) return UiAction::Daily;
+    if (key == sf::Keyboard::Num0) return UiAction::Exit;
+    return UiAction::None;
+}
+
+// Keys shared by the game over and level complete screens
+UiAction resultKey(ScreenLoop&, sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::Left) return UiAction::PrevLevel;
+    if (key == sf::Keyboard::Right) return UiAction::NextLevel;
+    if (key == sf::Keyboard::R) return UiAction::Retry; // restarts the current level
+    return UiAction::None;
+}
+
+UiAction dailyResultKey(ScreenLoop&, sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::R) return UiAction::Retry; // replays the daily
+    return UiAction::None;
+}
+
+UiAction playingKey(ScreenLoop& L, sf::Keyboard::Key key) {
+    Game& G = L.G;
+    // F2 toggles GPU shader / CPU strip terrain
+    if (key == sf::Keyboard::F2 && G.terrainShader.ready)
+        G.useTerrainShader = !G.useTerrainShader;
+    // F3 toggles the debug overlay
+    if (key == sf::Keyboard::F3)
+        G.showStats = !G.showStats;
+    // F8 toggles input latency measurement (summary printed when turned off)
+    if (key == sf::Keyboard::F8)
+        G.latency.setEnabled(!G.latency.enabled);
+    // F4 switches fixed-rate / vsync pacing
+    if (key == sf::Keyboard::F4)
+        G.pacer.setMode(L.window, G.pacer.mode == PacingMode::Fixed ? PacingMode::VSync : PacingMode::Fixed);
+    // Driving keys arrive through G.input, timestamped by the sampler thread
+    return UiAction::None;
+}
+
+void enterPlaying(ScreenLoop& L) {
+    seedInputs(L.G);
+    L.clock.restart();
+    L.accumulator = 0.0f;
+}
+
+// A throttle held when the level ended must not carry into the next one
+void exitPlaying(ScreenLoop& L) {
+    L.G.car.pressingLeft = false;
+    L.G.car.pressingRight = false;
+}
+
+void updatePlaying(ScreenLoop& L) {
+    L.dt = L.clock.restart().asSeconds();
+    L.accumulator += L.dt;
+    simulatePlaying(L.G, L.accumulator, nowUs());
+}
+
+void renderPlayingScreen(ScreenLoop& L) {
+    sf::Clock renderTimer;
+    renderPlaying(L.window, L.G, L.view, L.dt);
+    L.G.resolution.record(renderTimer.getElapsedTime().asMicroseconds() / 1000.0f + L.G.pacer.swapLoad_ms());
+    presentFrame(L.window, L.G);
+}
+
+// Menus keep the sampler queue drained so stale presses never reach a level
+void updateMenuScreen(ScreenLoop& L) { discardInputs(L.G); }
+
+void enterResultScreen(ScreenLoop& L) { L.G.prefetchLikelyLevels(); }
+
+void renderMenu(ScreenLoop& L) {
+    drawMenu(L.window, L.G);
+    presentFrame(L.window, L.G);
+    L.startup.onMenuPresented(true);
+}
+void renderGameOver(ScreenLoop& L) { drawGameOver(L.window, L.G); presentFrame(L.window, L.G); }
+void renderLevelComplete(ScreenLoop& L) { drawLevelCompleteMenu(L.window, L.G); presentFrame(L.window, L.G); }
+void renderGameCompleted(ScreenLoop& L) { drawGameCompletedMenu(L.window, L.G); presentFrame(L.window, L.G); }
+void renderDailyResult(ScreenLoop& L) { drawDailyResult(L.window, L.G); presentFrame(L.window, L.G); }
+void enterExit(ScreenLoop& L) {
+    L.G.capture.stop(); // needs the window's GL context
+    L.window.close();
+}
+
+// Indexed by Screen
+static const ScreenHandlers SCREEN_HANDLERS[MEM_SCREENS] = {
+    /* Menu          */ { true,  nullptr,           nullptr,     menuKey,    updateMenuScreen, renderMenu },
+    /* Playing       */ { false, enterPlaying,      exitPlaying, playingKey, updatePlaying,    renderPlayingScreen },
+    /* GameOver      */ { true,  enterResultScreen, nullptr,     resultKey,  updateMenuScreen, renderGameOver },
+    /* LevelComplete */ { true,  enterResultScreen, nullptr,     resultKey,  updateMenuScreen, renderLevelComplete },
+    /* Exit          */ { true,  enterExit,         nullptr,     nullptr,    nullptr,          nullptr },
+    /* GameCompleted */ { true,  nullptr,           nullptr,     nullptr,    updateMenuScreen, renderGameCompleted },
+    /* DailyResult   */ { true,  nullptr,           nullptr,     dailyResultKey, updateMenuScreen, renderDailyResult },
+};
+
+const ScreenHandlers& ScreenLoop::handlers(Screen s) const { return SCREEN_HANDLERS[static_cast<int>(s)]; }
+
+// ---------------------------- Main ------------------------------------
+// Allocation check: --alloc-check [frames]
+// Drives the playing loop (same simulate/render/present path as the game, with
+// the CPU terrain strip and the F3 overlay on) with the throttle held, counting
+// this thread's heap allocations per frame. After the warm-up any allocation
+// fails the check: the exit code is nonzero and the offenders are listed by
+// subsystem. Frames that restart the level after a crash or finish are skipped.
+static const int ALLOC_CHECK_WARMUP_FRAMES = 240;
+
+int runAllocCheck(int frames) {
+    sf::RenderWindow window(sf::VideoMode(WINDOW_W, WINDOW_H), "Black And White Racing (alloc check)");
+    window.setVisible(false);
+
+    Game G;
+    G.pacer.setMode(window, PacingMode::Fixed);
+    G.resolution.create();
+    G.reserveFrameBuffers();
+    G.setupFont();
+    G.terrainShader.load();
+    G.useTerrainShader = false;
+    G.showStats = true;
+    G.background.createAtlas();
+    G.buildLevel(0);
+    G.screen = Screen::Playing;
+
+    AllocCounter frame, steady;
+    int offendingFrames = 0, firstOffender = -1, skipped = 0;
+    sf::View view(sf::FloatRect(0, 0, WINDOW_W, WINDOW_H));
+    sf::Clock clock;
+    float accumulator = 0.0f;
+
+    for (int f = 0; f < frames + ALLOC_CHECK_WARMUP_FRAMES; f++) {
+        frame.clear();
+        t_allocCounter = &frame;
+
+        sf::Event ev;
+        while (window.pollEvent(ev)) {}
+        G.car.pressingRight = true;
 
-            accumulator -= DT_FIXED;
+        float dt = clock.restart().asSeconds();
+        accumulator += dt;
+        simulatePlaying(G, accumulator, nowUs());
+        bool restarted = G.screen != Screen::Playing;
+        if (!restarted) {
+            sf::Clock renderTimer;
+            renderPlaying(window, G, view, dt);
+            G.resolution.record(renderTimer.getElapsedTime().asMicroseconds() / 1000.0f + G.pacer.swapLoad_ms());
+            presentFrame(window, G);
         }
+        t_allocCounter = nullptr;
 
-        if (G.screen == Screen::GameOver) {
-            drawGameOver(window, G);
+        if (restarted) {
+            G.buildLevel(G.currentLevel);
+            G.screen = Screen::Playing;
+            skipped++;
             continue;
         }
-        if (G.screen == Screen::LevelComplete) {
-            drawLevelCompleteMenu(window, G);
-            continue;
+        if (f < ALLOC_CHECK_WARMUP_FRAMES || frame.total() == 0) continue;
+        offendingFrames++;
+        if (firstOffender < 0) firstOffender = f - ALLOC_CHECK_WARMUP_FRAMES;
+        for (int i = 0; i < AllocSubsystemCount; i++) {
+            steady.count[i] += frame.count[i];
+            steady.bytes[i] += frame.bytes[i];
         }
-        if (G.screen == Screen::GameCompleted) {
-            drawGameCompletedMenu(window, G);
-            continue;
+    }
+
+    std::cout << "Alloc check: " << frames << " frames after " << ALLOC_CHECK_WARMUP_FRAMES << " warm-up ("
+              << skipped << " level restarts skipped): " << offendingFrames << " frames allocated" << std::endl;
+    if (offendingFrames > 0) {
+        std::cout << "  first at frame " << firstOffender << std::endl;
+        for (int i = 0; i < AllocSubsystemCount; i++) {
+            if (steady.count[i] == 0) continue;
+            std::cout << "  " << std::setw(10) << ALLOC_SUBSYSTEM_NAMES[i] << ": " << steady.count[i]
+                      << " allocations, " << steady.bytes[i] << " bytes" << std::endl;
+        }
+    }
+    return offendingFrames > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    StartupProfile startupProfile; // first, so phases are timed from process start
+
+    // --tuning applies to the headless tools as well as the game
+    std::string tuningPath = TUNING_FILE;
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::strcmp(argv[i], "--tuning") == 0) tuningPath = argv[i + 1];
+
+    // Headless tools; a tool's optional arguments end at the next flag
+    auto given = [&](int at) { return at < argc && std::strncmp(argv[at], "--", 2) != 0; };
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--bench-particles") == 0) {
+            size_t n = given(i + 1) ? std::strtoul(argv[i + 1], nullptr, 10) : 100000;
+            return runParticleBenchmark(n > 0 ? n : 100000);
         }
+        if (std::strcmp(argv[i], "--bench-levels") == 0)
+            return runLevelBenchmark(given(i + 1) ? std::max(1, std::atoi(argv[i + 1])) : 50);
+        if (std::strcmp(argv[i], "--alloc-check") == 0)
+            return runAllocCheck(given(i + 1) ? std::max(1, std::atoi(argv[i + 1])) : 1200);
+        if (std::strcmp(argv[i], "--bench-startup") == 0)
+            return runStartupBenchmark(given(i + 1) ? std::max(1, std::atoi(argv[i + 1])) : 5);
+        if (std::strcmp(argv[i], "--render-overviews") == 0)
+            return runOverviewRenderer(given(i + 1) ? argv[i + 1] : OVERVIEW_DIR,
+                                       given(i + 2) ? std::max(1, std::atoi(argv[i + 2])) : 0,
+                                       given(i + 3) ? static_cast<sf::Uint32>(std::strtoul(argv[i + 3], nullptr, 10)) : 1u);
+        if (std::strcmp(argv[i], "--generate-levels") == 0)
+            return runLevelGenerator(given(i + 1) ? std::max(1, std::atoi(argv[i + 1])) : 1000,
+                                     given(i + 2) ? static_cast<sf::Uint32>(std::strtoul(argv[i + 2], nullptr, 10)) : 1u);
+        if (std::strcmp(argv[i], "--validate-levels") == 0) {
+            bool designed = !given(i + 1) || std::strcmp(argv[i + 1], "designed") == 0;
+            return runLevelValidator(designed ? 0 : std::max(1, std::atoi(argv[i + 1])),
+                                     given(i + 2) ? static_cast<sf::Uint32>(std::strtoul(argv[i + 2], nullptr, 10)) : 1u,
+                                     tuningPath);
+        }
+        if (std::strcmp(argv[i], "--bake-levels") == 0)
+            return runLevelBake(given(i + 1) ? static_cast<float>(std::atof(argv[i + 1])) : 0.6f, tuningPath);
+        if (std::strcmp(argv[i], "--bake-coins") == 0)
+            return runCoinBake(given(i + 1) ? std::max(1, std::atoi(argv[i + 1])) : 2000,
+                               given(i + 2) && std::strcmp(argv[i + 2], "risky") == 0, tuningPath);
+        if (std::strcmp(argv[i], "--daily") == 0)
+            return runDailyCheck(given(i + 1) ? std::max(1, std::atoi(argv[i + 1])) : utcDateToday());
+        if (std::strcmp(argv[i], "--write-tuning") == 0)
+            return writeTuningFile(given(i + 1) ? argv[i + 1] : TUNING_FILE);
+    }
 
-        // ---------------- Rendering (Playing) ----------------
-        window.clear(sf::Color::White);
+    float targetFrame_ms = 8.0f;
+    std::string captureCmd = CAPTURE_DEFAULT_CMD, captureDir = "capture";
+    bool serialStartup = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--mem-peaks") == 0) setMemoryPeakTracking(true);
+        if (std::strcmp(argv[i], "--serial-startup") == 0) serialStartup = true;
+    }
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--target-frame-ms") == 0)
+            targetFrame_ms = static_cast<float>(std::atof(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--capture-cmd") == 0)
+            captureCmd = argv[i + 1]; // encoder reading raw RGBA on stdin; {w} and {h} become the frame size
+        else if (std::strcmp(argv[i], "--capture-dir") == 0) {
+            captureDir = argv[i + 1];
+            captureCmd.clear(); // image sequence
+        }
+    }
+    TuningWatcher tuning;
+    tuning.start(tuningPath); // before any level is built
+    if (readLevelBake(LEVEL_BAKE_FILE, g_levelBake)) std::cout << "Level bake: loaded " << LEVEL_BAKE_FILE << std::endl;
 
-        // Camera follows car (clamped within level bounds + margins)
-        float camX = G.car.x_px;
-        float halfW = WINDOW_W * 0.5f;
-        camX = clampf(camX, halfW, std::max(halfW, G.level.finishX_px - halfW));
-        view.setCenter(camX, WINDOW_H * 0.5f);
-        window.setView(view);
+    double gameBegin_ms = startupProfile.now_ms();
+    Game G;
+    startupProfile.record("game state", gameBegin_ms, false);
 
-        // Draw terrain in view range
-        float xStart = view.getCenter().x - halfW - 50.0f;
-        float xEnd = view.getCenter().x + halfW + 50.0f;
-        drawTerrain(window, G, std::max(0.0f, xStart), std::min(G.level.finishX_px + 200.0f, xEnd));
+    // Font, overviews, atlas and level 1 load on workers while the window opens
+    Startup startup(startupProfile, !serialStartup);
+    startup.launch(G);
 
-        // Draw pickups
-        drawPickups(window, G, xStart, xEnd);
+    sf::RenderWindow window;
+    startupProfile.time("window", false, [&] {
+        window.create(sf::VideoMode(WINDOW_W, WINDOW_H), "Black And White Racing");
+    });
+    G.pacer.setMode(window, PacingMode::Fixed);
+    G.resolution.target_ms = targetFrame_ms;
+    G.reserveFrameBuffers();
+    G.input.start();
+    G.capture.command = captureCmd;
+    G.capture.directory = captureDir;
 
-        // Draw car + man
-        drawVehicle(window, G);
+    ScreenLoop screens(window, G, startup);
 
-        // Reset to UI view for HUD
-        window.setView(window.getDefaultView());
-        drawHUD(window, G);
+    while (window.isOpen()) {
+        sampleMemoryPeaks(G.screen);
+        startup.poll(G);
+        if (tuning.pending.load(std::memory_order_relaxed) && startup.done && G.prefetcher.idle()) {
+            Tuning next;
+            if (tuning.take(next)) applyTuning(G, next);
+        }
 
-        window.display();
+        screens.frame();
     } // <-- closes while(window.isOpen())
 
+    G.latency.report();
+    screens.printUsage();
+    if (g_memory.trackPeaks.load()) printMemoryReport(G);
 
     return 0;
 }